@@ -0,0 +1,380 @@
+// Microbenchmarks for the graph hot paths. Every benchmark runs over a grid
+// of depths and new vertices counts with a fixed seed and prints one JSON
+// object per line:
+//   {"benchmark": "graph/add_edge", "depth": 8, "new_vertices_count": 3,
+//    "seed": 42, "repetitions": 5, "items": 1234, "ns_per_op": 12.3,
+//    "items_per_second": 8.1e+07, "allocations_per_op": 0.01}
+// Times are medians over the repetitions, an op is one item.
+//
+// Usage: graph_benchmarks [--filter=<substring>] [--depths=6,9,12]
+//                         [--new-vertices-counts=3,5] [--repetitions=5]
+// Build it with the graph_benchmarks CMake target, see README.md.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+#include "configs.hpp"
+#include "graph.hpp"
+#include "graph_generator.hpp"
+#include "graph_json_printing.hpp"
+#include "graph_printing.hpp"
+#include "logger.hpp"
+
+namespace {
+std::atomic<std::size_t> allocations_count = 0;
+// Results of the timed code are added here, so it can't be optimized away.
+volatile std::size_t result_sink = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+// Over-aligned allocations, std::pmr::new_delete_resource() always uses these.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  allocations_count.fetch_add(1, std::memory_order_relaxed);
+  const auto alignment_size = static_cast<std::size_t>(alignment);
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  const auto aligned_size =
+      (std::max<std::size_t>(size, 1) + alignment_size - 1) / alignment_size *
+      alignment_size;
+  if (void* pointer = std::aligned_alloc(alignment_size, aligned_size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+  std::free(pointer);
+}
+
+namespace {
+using uni_course_cpp::Graph;
+using uni_course_cpp::GraphGenerator;
+
+static constexpr std::uint64_t kSeed = 42;
+static constexpr int kDefaultRepetitions = 5;
+static constexpr int kLoggerLinesCount = 10000;
+static constexpr const char* kDefaultDepths = "6,9,12";
+static constexpr const char* kDefaultNewVerticesCounts = "3,5";
+
+struct GridPoint {
+  Graph::Depth depth = 0;
+  int new_vertices_count = 0;
+};
+
+struct Options {
+  std::string filter;
+  std::vector<int> depths;
+  std::vector<int> new_vertices_counts;
+  int repetitions = kDefaultRepetitions;
+};
+
+// Untimed preparation of one repetition, returns the timed part. The timed
+// part returns the number of items it processed.
+using Benchmark =
+    std::function<std::function<std::size_t()>(const GridPoint& point)>;
+
+// Swallows everything, stands in for the console while the Logger runs.
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int character) override { return character; }
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    return count;
+  }
+};
+
+struct Measurement {
+  double seconds = 0;
+  std::size_t items = 0;
+  std::size_t allocations = 0;
+};
+
+std::vector<int> parse_ints(const std::string& string) {
+  auto ints = std::vector<int>();
+  auto stream = std::stringstream(string);
+  for (std::string item; std::getline(stream, item, ',');) {
+    ints.push_back(std::stoi(item));
+  }
+  return ints;
+}
+
+Options parse_options(int argc, char** argv) {
+  auto options = Options();
+  options.depths = parse_ints(kDefaultDepths);
+  options.new_vertices_counts = parse_ints(kDefaultNewVerticesCounts);
+  for (int i = 1; i < argc; i++) {
+    const auto argument = std::string(argv[i]);
+    const auto value = argument.substr(argument.find('=') + 1);
+    if (argument.rfind("--filter=", 0) == 0) {
+      options.filter = value;
+    } else if (argument.rfind("--depths=", 0) == 0) {
+      options.depths = parse_ints(value);
+    } else if (argument.rfind("--new-vertices-counts=", 0) == 0) {
+      options.new_vertices_counts = parse_ints(value);
+    } else if (argument.rfind("--repetitions=", 0) == 0) {
+      options.repetitions = std::max(1, std::stoi(value));
+    } else {
+      throw std::invalid_argument("Unknown argument " + argument);
+    }
+  }
+  return options;
+}
+
+Graph generate_graph(const GridPoint& point) {
+  return GraphGenerator(
+             GraphGenerator::Params(point.depth, point.new_vertices_count,
+                                    kSeed))
+      .generate();
+}
+
+Measurement measure(const std::function<std::size_t()>& run) {
+  const auto allocations_before = allocations_count.load();
+  const auto start = std::chrono::steady_clock::now();
+  const auto items = run();
+  const auto finish = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double>(finish - start).count(), items,
+          allocations_count.load() - allocations_before};
+}
+
+class BenchmarkRunner {
+ public:
+  BenchmarkRunner(const Options& options, std::ostream& output)
+      : options_(options), output_(output) {}
+
+  void run(const std::string& name, const Benchmark& benchmark) const {
+    if (name.find(options_.filter) == std::string::npos) {
+      return;
+    }
+    for (const auto depth : options_.depths) {
+      for (const auto new_vertices_count : options_.new_vertices_counts) {
+        const auto point = GridPoint{depth, new_vertices_count};
+        // The first run warms up caches and the thread pool, it isn't
+        // reported.
+        measure(benchmark(point));
+        auto measurements = std::vector<Measurement>();
+        for (int i = 0; i < options_.repetitions; i++) {
+          measurements.push_back(measure(benchmark(point)));
+        }
+        report(name, point, measurements);
+      }
+    }
+  }
+
+ private:
+  void report(const std::string& name,
+              const GridPoint& point,
+              std::vector<Measurement>& measurements) const {
+    std::sort(measurements.begin(), measurements.end(),
+              [](const Measurement& first, const Measurement& second) {
+                return first.seconds < second.seconds;
+              });
+    const auto& median = measurements[measurements.size() / 2];
+    const auto items = std::max<std::size_t>(median.items, 1);
+    output_ << "{\"benchmark\": \"" << name
+            << "\", \"depth\": " << point.depth
+            << ", \"new_vertices_count\": " << point.new_vertices_count
+            << ", \"seed\": " << kSeed
+            << ", \"repetitions\": " << options_.repetitions
+            << ", \"items\": " << median.items
+            << ", \"ns_per_op\": " << median.seconds * 1e9 / items
+            << ", \"items_per_second\": " << items / median.seconds
+            << ", \"allocations_per_op\": "
+            << static_cast<double>(median.allocations) / items << "}"
+            << std::endl;
+  }
+
+  const Options& options_;
+  std::ostream& output_;
+};
+
+using Edges = std::vector<std::pair<Graph::VertexId, Graph::VertexId>>;
+
+Edges get_edges(const Graph& graph) {
+  auto edges = Edges();
+  edges.reserve(graph.get_edges().size());
+  for (const auto& edge : graph.get_edges()) {
+    edges.emplace_back(edge.from_vertex_id, edge.to_vertex_id);
+  }
+  return edges;
+}
+
+Graph get_graph_with_vertices(std::size_t vertices_count) {
+  auto graph = Graph();
+  for (std::size_t i = 0; i < vertices_count; i++) {
+    graph.add_vertex();
+  }
+  return graph;
+}
+
+void run_graph_benchmarks(const BenchmarkRunner& runner) {
+  runner.run("graph/add_vertex", [](const GridPoint& point) {
+    const auto vertices_count = generate_graph(point).get_vertices().size();
+    return [vertices_count]() {
+      auto graph = Graph();
+      for (std::size_t i = 0; i < vertices_count; i++) {
+        graph.add_vertex();
+      }
+      return vertices_count;
+    };
+  });
+
+  // Replays the edges of a generated graph in their original order, so every
+  // edge finds its endpoints at the same depths as during generation.
+  runner.run("graph/add_edge", [](const GridPoint& point) {
+    const auto generated_graph = generate_graph(point);
+    auto edges = std::make_shared<Edges>(get_edges(generated_graph));
+    auto graph = std::make_shared<Graph>(
+        get_graph_with_vertices(generated_graph.get_vertices().size()));
+    return [edges, graph]() {
+      for (const auto& [from_vertex_id, to_vertex_id] : *edges) {
+        graph->add_edge(from_vertex_id, to_vertex_id);
+      }
+      return edges->size();
+    };
+  });
+
+  // Every edge is queried in both directions together with as many pairs
+  // that aren't connected.
+  runner.run("graph/has_edge", [](const GridPoint& point) {
+    auto graph = std::make_shared<Graph>(generate_graph(point));
+    auto queries = std::make_shared<Edges>(get_edges(*graph));
+    const auto vertices_count = graph->get_vertices().size();
+    const auto edges_count = queries->size();
+    for (std::size_t i = 0; i < edges_count; i++) {
+      const auto [from_vertex_id, to_vertex_id] = (*queries)[i];
+      queries->emplace_back(to_vertex_id, from_vertex_id);
+      queries->emplace_back(from_vertex_id,
+                            (to_vertex_id + i + 1) % vertices_count);
+    }
+    return [graph, queries]() {
+      std::size_t found_count = 0;
+      for (const auto& [first_vertex_id, second_vertex_id] : *queries) {
+        found_count += graph->has_edge(first_vertex_id, second_vertex_id);
+      }
+      result_sink = result_sink + found_count;
+      return queries->size();
+    };
+  });
+}
+
+void run_generator_benchmarks(const BenchmarkRunner& runner) {
+  runner.run("generator/grey", [](const GridPoint& point) {
+    return [point]() {
+      auto graph = Graph();
+      GraphGenerator(GraphGenerator::Params(point.depth,
+                                            point.new_vertices_count, kSeed))
+          .generate_phase(GraphGenerator::Phase::Grey, graph);
+      return graph.get_vertices().size();
+    };
+  });
+
+  const auto run_color_benchmark = [&runner](const std::string& name,
+                                             GraphGenerator::Phase phase) {
+    runner.run(name, [phase](const GridPoint& point) {
+      const auto generator = GraphGenerator(
+          GraphGenerator::Params(point.depth, point.new_vertices_count, kSeed));
+      auto grey_graph = Graph();
+      generator.generate_phase(GraphGenerator::Phase::Grey, grey_graph);
+      auto graph = std::make_shared<Graph>(std::move(grey_graph));
+      return [generator, graph, phase]() {
+        generator.generate_phase(phase, *graph);
+        return graph->get_vertices().size();
+      };
+    });
+  };
+  run_color_benchmark("generator/green", GraphGenerator::Phase::Green);
+  run_color_benchmark("generator/yellow", GraphGenerator::Phase::Yellow);
+  run_color_benchmark("generator/red", GraphGenerator::Phase::Red);
+}
+
+void run_printing_benchmarks(const BenchmarkRunner& runner) {
+  runner.run("printing/print_graph", [](const GridPoint& point) {
+    auto graph = std::make_shared<Graph>(generate_graph(point));
+    return [graph]() {
+      const auto description = uni_course_cpp::printing::print_graph(*graph);
+      result_sink = result_sink + description.size();
+      return graph->get_vertices().size() + graph->get_edges().size();
+    };
+  });
+
+  runner.run("printing/json/print_graph", [](const GridPoint& point) {
+    auto graph = std::make_shared<Graph>(generate_graph(point));
+    return [graph]() {
+      const auto json = uni_course_cpp::printing::json::print_graph(*graph);
+      result_sink = result_sink + json.size();
+      return graph->get_vertices().size() + graph->get_edges().size();
+    };
+  });
+}
+
+// Logs the summary of the grid graph, the line main logs per graph. Console
+// output of the Logger is discarded while the benchmark runs.
+void run_logger_benchmarks(const BenchmarkRunner& runner) {
+  auto& logger = uni_course_cpp::Logger::get_logger();
+  const auto run_logger_benchmark = [&runner, &logger](
+                                          const std::string& name,
+                                          uni_course_cpp::Logger::Mode mode) {
+    logger.set_mode(mode);
+    runner.run(name, [&logger](const GridPoint& point) {
+      const auto line =
+          uni_course_cpp::printing::print_graph(generate_graph(point));
+      return [&logger, line]() {
+        for (int i = 0; i < kLoggerLinesCount; i++) {
+          logger.log(line);
+        }
+        logger.flush();
+        return static_cast<std::size_t>(kLoggerLinesCount);
+      };
+    });
+    logger.set_mode(uni_course_cpp::Logger::Mode::Blocking);
+  };
+
+  auto null_buffer = NullBuffer();
+  auto* const console_buffer = std::cout.rdbuf(&null_buffer);
+  run_logger_benchmark("logger/log_blocking",
+                       uni_course_cpp::Logger::Mode::Blocking);
+  run_logger_benchmark("logger/log_async", uni_course_cpp::Logger::Mode::Async);
+  std::cout.rdbuf(console_buffer);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto options = parse_options(argc, argv);
+  std::filesystem::create_directory(uni_course_cpp::config::kTempDirectoryPath);
+  // The Logger writes to std::cout, results keep the console buffer.
+  std::ostream output(std::cout.rdbuf());
+  const auto runner = BenchmarkRunner(options, output);
+  run_graph_benchmarks(runner);
+  run_generator_benchmarks(runner);
+  run_printing_benchmarks(runner);
+  run_logger_benchmarks(runner);
+  return 0;
+}
@@ -7,6 +7,8 @@ namespace config {
 const std::string kTempDirectoryPath = "./temp/";
 const std::string kLogFilename = "log.txt";
 const std::string kLogFilePath = kTempDirectoryPath + kLogFilename;
+const std::string kTraceFilename = "trace.json";
+const std::string kTraceFilePath = kTempDirectoryPath + kTraceFilename;
 
 }  // namespace config
 }  // namespace uni_course_cpp
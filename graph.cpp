@@ -1,9 +1,51 @@
 #include "graph.hpp"
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
 namespace uni_course_cpp {
 
+Graph::Graph(std::shared_ptr<std::pmr::memory_resource> memory_resource)
+    : memory_resource_owner_(memory_resource),
+      vertices_(memory_resource.get()),
+      vertex_depths_(memory_resource.get()),
+      vertex_positions_at_depth_(memory_resource.get()),
+      adjacency_list_(memory_resource.get()),
+      adjacency_offsets_(memory_resource.get()),
+      adjacency_edge_ids_(memory_resource.get()),
+      adjacency_vertex_ids_(memory_resource.get()),
+      depth_list_(memory_resource.get()),
+      edges_(memory_resource.get()),
+      edge_keys_(memory_resource.get()),
+      has_edge_keys_(memory_resource == nullptr) {}
+
+Graph::Graph(FrozenParts&& parts)
+    : vertex_depths_(std::move(parts.vertex_depths)),
+      adjacency_offsets_(std::move(parts.adjacency_offsets)),
+      adjacency_edge_ids_(std::move(parts.adjacency_edge_ids)),
+      depth_list_(std::move(parts.depth_list)),
+      edges_(std::move(parts.edges)),
+      frozen_(true),
+      vertex_id_counter_(vertex_depths_.size()),
+      edge_id_counter_(edges_.size()) {
+  assert(adjacency_offsets_.size() == vertex_depths_.size() + 1 &&
+         "Adjacency offsets don't match vertices");
+  vertices_.reserve(vertex_depths_.size());
+  for (VertexId vertex_id = 0; vertex_id < vertex_id_counter_; vertex_id++) {
+    vertices_.emplace_back(vertex_id);
+  }
+  if (depth_list_.empty()) {
+    for (VertexId vertex_id = 0; vertex_id < vertex_id_counter_; vertex_id++) {
+      const auto depth = vertex_depths_[vertex_id];
+      if (get_depth() < depth) {
+        depth_list_.resize(depth);
+      }
+      depth_list_[depth - kGraphDefaultDepth].emplace_back(vertex_id);
+    }
+  }
+  build_adjacency_vertex_ids();
+}
+
 Graph::Edge::Color Graph::calculate_edge_color(VertexId from_vertex_id,
                                                VertexId to_vertex_id) const {
   const auto from_vertex_depth = get_vertex_depth(from_vertex_id);
@@ -28,66 +70,90 @@ Graph::Edge::Color Graph::calculate_edge_color(VertexId from_vertex_id,
 
 bool Graph::has_vertex(Graph::VertexId vertex_id) const {
   assert(vertex_id >= 0 && "vertex_id < 0");
-  for (const auto& vertex : vertices_) {
-    if (vertex.id == vertex_id) {
-      return true;
-    }
-  }
-  return false;
+  return vertex_id < static_cast<VertexId>(vertices_.size());
 }
 
 bool Graph::has_edge(VertexId first_vertex_id,
                      VertexId second_vertex_id) const {
   assert(first_vertex_id >= 0 && "first_vertex_id < 0");
   assert(second_vertex_id >= 0 && "second_vertex_id < 0");
-  if (first_vertex_id != second_vertex_id) {
-    for (const auto first_edge_id : adjacency_list_.at(first_vertex_id)) {
-      for (const auto second_edge_id : adjacency_list_.at(second_vertex_id)) {
-        if (first_edge_id == second_edge_id) {
-          return true;
-        }
-      }
-    }
-  } else {
-    for (const auto edge_id : adjacency_list_.at(first_vertex_id)) {
-      if (edge_id_to_edge_.at(edge_id).color == Edge::Color::Green) {
-        return true;
-      }
-    }
+  if (frozen_) {
+    const auto* const vertex_ids = adjacency_vertex_ids_.data();
+    return std::binary_search(
+        vertex_ids + adjacency_offsets_.at(first_vertex_id),
+        vertex_ids + adjacency_offsets_.at(first_vertex_id + 1),
+        second_vertex_id);
+  }
+  if (has_edge_keys_) {
+    return edge_keys_.count(get_edge_key(first_vertex_id, second_vertex_id)) !=
+           0;
   }
-  return false;
+  const auto& first_edge_ids = adjacency_list_.at(first_vertex_id);
+  const auto& second_edge_ids = adjacency_list_.at(second_vertex_id);
+  const auto& edge_ids = first_edge_ids.size() <= second_edge_ids.size()
+                             ? first_edge_ids
+                             : second_edge_ids;
+  const auto edge_key = get_edge_key(first_vertex_id, second_vertex_id);
+  return std::any_of(edge_ids.cbegin(), edge_ids.cend(),
+                     [this, edge_key](EdgeId edge_id) {
+                       const auto& edge = edges_[edge_id];
+                       return get_edge_key(edge.from_vertex_id,
+                                           edge.to_vertex_id) == edge_key;
+                     });
+}
+
+std::uint64_t Graph::get_edge_key(VertexId first_vertex_id,
+                                  VertexId second_vertex_id) {
+  const auto [min_vertex_id, max_vertex_id] =
+      std::minmax(first_vertex_id, second_vertex_id);
+  return (static_cast<std::uint64_t>(min_vertex_id) << 32) |
+         static_cast<std::uint32_t>(max_vertex_id);
 }
 
 Graph::VertexId Graph::add_vertex() {
+  assert(!frozen_ && "Graph is frozen");
   const auto& new_vertex = vertices_.emplace_back(get_new_vertex_id());
-  adjacency_list_[new_vertex.id] = {};
-  vertex_depths_.emplace(new_vertex.id, kGraphDefaultDepth);
-  depth_list_[kGraphDefaultDepth].emplace_back(new_vertex.id);
+  adjacency_list_.emplace_back();
+  vertex_depths_.emplace_back(kGraphDefaultDepth);
+  if (depth_list_.empty()) {
+    depth_list_.emplace_back();
+  }
+  vertex_positions_at_depth_.emplace_back(depth_list_.front().size());
+  depth_list_.front().emplace_back(new_vertex.id);
 
   return new_vertex.id;
 }
 
 void Graph::update_depth(VertexId first_vertex_id, VertexId second_vertex_id) {
   const Depth second_vertex_depth = get_vertex_depth(first_vertex_id) + 1;
-  vertex_depths_[second_vertex_id] = second_vertex_depth;
-  auto& vertices_at_default_depth = depth_list_.at(kGraphDefaultDepth);
-  depth_list_[second_vertex_depth].emplace_back(second_vertex_id);
-  for (auto vertex_id = vertices_at_default_depth.begin();
-       vertex_id != vertices_at_default_depth.end(); ++vertex_id) {
-    if (*vertex_id == second_vertex_id) {
-      vertices_at_default_depth.erase(vertex_id);
-      break;
-    }
+  auto& vertices_at_previous_depth =
+      depth_list_[get_vertex_depth(second_vertex_id) - kGraphDefaultDepth];
+  const auto previous_position = vertex_positions_at_depth_[second_vertex_id];
+  const auto last_vertex_id = vertices_at_previous_depth.back();
+  vertices_at_previous_depth[previous_position] = last_vertex_id;
+  vertex_positions_at_depth_[last_vertex_id] = previous_position;
+  vertices_at_previous_depth.pop_back();
+
+  if (get_depth() < second_vertex_depth) {
+    depth_list_.resize(second_vertex_depth);
   }
+  auto& vertices_at_new_depth =
+      depth_list_[second_vertex_depth - kGraphDefaultDepth];
+  vertex_positions_at_depth_[second_vertex_id] = vertices_at_new_depth.size();
+  vertices_at_new_depth.emplace_back(second_vertex_id);
+  vertex_depths_[second_vertex_id] = second_vertex_depth;
 }
 
 void Graph::add_edge(VertexId first_vertex_id, VertexId second_vertex_id) {
+  assert(!frozen_ && "Graph is frozen");
   assert(has_vertex(first_vertex_id) && "first_vertex_id doesn't exist");
   assert(has_vertex(second_vertex_id) && "second_vertex_id doesn't exist");
   const auto color = calculate_edge_color(first_vertex_id, second_vertex_id);
   const auto new_edge_id = get_new_edge_id();
-  edge_id_to_edge_.emplace(
-      new_edge_id, Edge(new_edge_id, first_vertex_id, second_vertex_id, color));
+  edges_.emplace_back(new_edge_id, first_vertex_id, second_vertex_id, color);
+  if (has_edge_keys_) {
+    edge_keys_.insert(get_edge_key(first_vertex_id, second_vertex_id));
+  }
   adjacency_list_[first_vertex_id].emplace_back(new_edge_id);
   if (color != Edge::Color::Green) {
     adjacency_list_[second_vertex_id].emplace_back(new_edge_id);
@@ -97,4 +163,133 @@ void Graph::add_edge(VertexId first_vertex_id, VertexId second_vertex_id) {
   }
 }
 
+void Graph::add_edges(
+    const std::vector<std::pair<VertexId, VertexId>>& vertex_id_pairs) {
+  edges_.reserve(edges_.size() + vertex_id_pairs.size());
+  if (has_edge_keys_) {
+    edge_keys_.reserve(edge_keys_.size() + vertex_id_pairs.size());
+  }
+  for (const auto& [first_vertex_id, second_vertex_id] : vertex_id_pairs) {
+    add_edge(first_vertex_id, second_vertex_id);
+  }
+}
+
+void Graph::splice_subgraph(const Graph& subgraph, VertexId root_vertex_id) {
+  assert(!frozen_ && "Graph is frozen");
+  assert(has_vertex(root_vertex_id) && "root_vertex_id doesn't exist");
+  if (subgraph.vertices_.empty()) {
+    return;
+  }
+  assert(subgraph.vertex_ids_at_depth(kGraphDefaultDepth).size() == 1 &&
+         "Subgraph must have a single root");
+  const VertexId vertex_id_offset = vertex_id_counter_ - 1;
+  const EdgeId edge_id_offset = edge_id_counter_;
+  const Depth depth_offset =
+      get_vertex_depth(root_vertex_id) - kGraphDefaultDepth;
+  const auto get_vertex_id = [root_vertex_id,
+                              vertex_id_offset](VertexId subgraph_vertex_id) {
+    return subgraph_vertex_id == 0 ? root_vertex_id
+                                   : subgraph_vertex_id + vertex_id_offset;
+  };
+
+  for (std::size_t i = 1; i < subgraph.vertices_.size(); i++) {
+    vertices_.emplace_back(get_new_vertex_id());
+    vertex_depths_.emplace_back(subgraph.vertex_depths_[i] + depth_offset);
+    adjacency_list_.emplace_back();
+  }
+  vertex_positions_at_depth_.resize(vertices_.size());
+
+  if (get_depth() < subgraph.get_depth() + depth_offset) {
+    depth_list_.resize(subgraph.get_depth() + depth_offset);
+  }
+  for (Depth depth = kGraphDefaultDepth + 1; depth <= subgraph.get_depth();
+       depth++) {
+    auto& vertex_ids = depth_list_[depth + depth_offset - kGraphDefaultDepth];
+    for (const auto subgraph_vertex_id : subgraph.vertex_ids_at_depth(depth)) {
+      const auto vertex_id = get_vertex_id(subgraph_vertex_id);
+      vertex_positions_at_depth_[vertex_id] = vertex_ids.size();
+      vertex_ids.emplace_back(vertex_id);
+    }
+  }
+
+  for (const auto& edge : subgraph.edges_) {
+    const auto from_vertex_id = get_vertex_id(edge.from_vertex_id);
+    const auto to_vertex_id = get_vertex_id(edge.to_vertex_id);
+    edges_.emplace_back(get_new_edge_id(), from_vertex_id, to_vertex_id,
+                        edge.color);
+    if (has_edge_keys_) {
+      edge_keys_.insert(get_edge_key(from_vertex_id, to_vertex_id));
+    }
+  }
+  for (std::size_t i = 0; i < subgraph.vertices_.size(); i++) {
+    auto& edge_ids = adjacency_list_[get_vertex_id(i)];
+    for (const auto edge_id : subgraph.edge_ids_connected_to_vertex(i)) {
+      edge_ids.emplace_back(edge_id + edge_id_offset);
+    }
+  }
+}
+
+void Graph::freeze() {
+  if (frozen_) {
+    return;
+  }
+  adjacency_offsets_.resize(adjacency_list_.size() + 1);
+  std::size_t offset = 0;
+  for (std::size_t vertex_id = 0; vertex_id < adjacency_list_.size();
+       vertex_id++) {
+    adjacency_offsets_[vertex_id] = offset;
+    offset += adjacency_list_[vertex_id].size();
+  }
+  adjacency_offsets_.back() = offset;
+
+  adjacency_edge_ids_.reserve(offset);
+  for (const auto& edge_ids : adjacency_list_) {
+    adjacency_edge_ids_.insert(adjacency_edge_ids_.end(), edge_ids.cbegin(),
+                               edge_ids.cend());
+  }
+  adjacency_list_.clear();
+  adjacency_list_.shrink_to_fit();
+  vertex_positions_at_depth_.clear();
+  vertex_positions_at_depth_.shrink_to_fit();
+  edge_keys_ =
+      std::pmr::unordered_set<std::uint64_t>(edge_keys_.get_allocator());
+  build_adjacency_vertex_ids();
+  // An arena doesn't reuse freed memory, shrinking would only copy.
+  if (memory_resource_owner_.is_default()) {
+    edges_.shrink_to_fit();
+    vertices_.shrink_to_fit();
+    vertex_depths_.shrink_to_fit();
+  }
+  frozen_ = true;
+}
+
+void Graph::build_adjacency_vertex_ids() {
+  adjacency_vertex_ids_.resize(adjacency_edge_ids_.size());
+  for (std::size_t vertex_id = 0; vertex_id + 1 < adjacency_offsets_.size();
+       vertex_id++) {
+    const auto begin = adjacency_offsets_[vertex_id];
+    const auto end = adjacency_offsets_[vertex_id + 1];
+    for (auto i = begin; i < end; i++) {
+      const auto& edge = edges_[adjacency_edge_ids_[i]];
+      adjacency_vertex_ids_[i] =
+          edge.from_vertex_id == static_cast<VertexId>(vertex_id)
+              ? edge.to_vertex_id
+              : edge.from_vertex_id;
+    }
+    std::sort(adjacency_vertex_ids_.begin() + begin,
+              adjacency_vertex_ids_.begin() + end);
+  }
+}
+
+Graph::IdsView<Graph::EdgeId> Graph::edge_ids_connected_to_vertex(
+    VertexId vertex_id) const {
+  if (frozen_) {
+    const auto* const edge_ids = adjacency_edge_ids_.data();
+    return IdsView<EdgeId>(edge_ids + adjacency_offsets_.at(vertex_id),
+                           edge_ids + adjacency_offsets_.at(vertex_id + 1));
+  }
+  const auto& edge_ids = adjacency_list_.at(vertex_id);
+  return IdsView<EdgeId>(edge_ids.data(), edge_ids.data() + edge_ids.size());
+}
+
 }  // namespace uni_course_cpp
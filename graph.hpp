@@ -1,5 +1,10 @@
 #pragma once
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace uni_course_cpp {
@@ -34,6 +39,44 @@ class Graph {
     const Color color;
   };
 
+  template <typename Id>
+  class IdsView {
+   public:
+    IdsView(const Id* begin, const Id* end) : begin_(begin), end_(end) {}
+
+    const Id* begin() const { return begin_; }
+    const Id* end() const { return end_; }
+    std::size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    Id operator[](std::size_t index) const { return begin_[index]; }
+
+   private:
+    const Id* begin_ = nullptr;
+    const Id* end_ = nullptr;
+  };
+
+  // Everything a frozen graph is made of. Vertex ids are the indexes of
+  // `vertex_depths`, edge ids are the indexes of `edges`. If `depth_list` is
+  // empty, it is rebuilt from `vertex_depths` in vertex id order.
+  struct FrozenParts {
+    std::pmr::vector<Depth> vertex_depths;
+    std::pmr::vector<std::size_t> adjacency_offsets;
+    std::pmr::vector<EdgeId> adjacency_edge_ids;
+    std::pmr::vector<std::pmr::vector<VertexId>> depth_list;
+    std::pmr::vector<Edge> edges;
+  };
+
+  // Allocates from the global heap.
+  Graph() = default;
+
+  // Allocates everything from `memory_resource` and keeps it alive as long as
+  // the graph lives. Moving the graph moves the resource along, copies and
+  // assignment targets keep their own.
+  explicit Graph(std::shared_ptr<std::pmr::memory_resource> memory_resource);
+
+  // Builds a frozen graph in bulk, edge colors are taken as is.
+  explicit Graph(FrozenParts&& parts);
+
   bool has_vertex(VertexId vertex_id) const;
 
   bool has_edge(VertexId first_vertex_id, VertexId second_vertex_id) const;
@@ -42,41 +85,97 @@ class Graph {
 
   void add_edge(VertexId first_vertex_id, VertexId second_vertex_id);
 
+  void add_edges(
+      const std::vector<std::pair<VertexId, VertexId>>& vertex_id_pairs);
+
   void update_depth(VertexId first_vertex_id, VertexId second_vertex_id);
 
-  const std::vector<EdgeId>& edge_ids_connected_to_vertex(
-      VertexId vertex_id) const {
-    return adjacency_list_.at(vertex_id);
-  }
+  // Appends every vertex and edge of `subgraph` in one step. The subgraph's
+  // vertex 0 is merged into `root_vertex_id`, the other vertices and all edges
+  // get new ids in their original order. Edge colors are copied as is.
+  void splice_subgraph(const Graph& subgraph, VertexId root_vertex_id);
 
-  const std::vector<Vertex>& get_vertices() const { return vertices_; }
+  // Packs the adjacency lists into one compressed-sparse-row array. The graph
+  // can't be modified afterwards, has_edge() binary-searches the sorted
+  // neighbors of a vertex. Heap-backed graphs release the adjacency lists and
+  // the edge set they answered has_edge() from while edges were added. An
+  // arena frees nothing before the graph is gone, so arena-backed graphs
+  // never build that set, and their adjacency lists stay in the arena next to
+  // the packed copy.
+  void freeze();
 
-  const std::unordered_map<EdgeId, Edge>& get_edges_ids_to_edges() const {
-    return edge_id_to_edge_;
-  }
+  bool is_frozen() const { return frozen_; }
+
+  IdsView<EdgeId> edge_ids_connected_to_vertex(VertexId vertex_id) const;
+
+  const std::pmr::vector<Vertex>& get_vertices() const { return vertices_; }
+
+  const std::pmr::vector<Edge>& get_edges() const { return edges_; }
+
+  const Edge& get_edge(EdgeId edge_id) const { return edges_.at(edge_id); }
 
   Depth get_vertex_depth(VertexId vertex_id) const {
     return vertex_depths_.at(vertex_id);
   }
 
-  const std::vector<VertexId>& vertex_ids_at_depth(Depth depth) const {
-    return depth_list_.at(depth);
+  const std::pmr::vector<VertexId>& vertex_ids_at_depth(Depth depth) const {
+    return depth_list_.at(depth - kGraphDefaultDepth);
   }
 
   int get_depth() const { return depth_list_.size(); }
 
  private:
-  std::vector<Vertex> vertices_;
-  std::unordered_map<VertexId, std::vector<EdgeId>> adjacency_list_;
-  std::unordered_map<Depth, std::vector<VertexId>> depth_list_;
-  std::unordered_map<VertexId, Depth> vertex_depths_;
-  std::unordered_map<EdgeId, Edge> edge_id_to_edge_;
+  // Shares ownership of the resource the containers allocate from. Only a
+  // move takes the other graph's resource, since only a move takes its
+  // containers' memory as well.
+  class MemoryResourceOwner {
+   public:
+    MemoryResourceOwner() = default;
+    explicit MemoryResourceOwner(
+        std::shared_ptr<std::pmr::memory_resource> memory_resource)
+        : memory_resource_(std::move(memory_resource)) {}
+    MemoryResourceOwner(const MemoryResourceOwner&) {}
+    MemoryResourceOwner(MemoryResourceOwner&&) = default;
+    MemoryResourceOwner& operator=(const MemoryResourceOwner&) {
+      return *this;
+    }
+    MemoryResourceOwner& operator=(MemoryResourceOwner&&) { return *this; }
+
+    bool is_default() const { return memory_resource_ == nullptr; }
+
+   private:
+    std::shared_ptr<std::pmr::memory_resource> memory_resource_;
+  };
+
+  // Declared first so that it outlives the containers.
+  MemoryResourceOwner memory_resource_owner_;
+  std::pmr::vector<Vertex> vertices_;
+  std::pmr::vector<Depth> vertex_depths_;
+  std::pmr::vector<std::size_t> vertex_positions_at_depth_;
+  std::pmr::vector<std::pmr::vector<EdgeId>> adjacency_list_;
+  std::pmr::vector<std::size_t> adjacency_offsets_;
+  std::pmr::vector<EdgeId> adjacency_edge_ids_;
+  // Other ends of the edges in `adjacency_edge_ids_`, sorted per vertex.
+  std::pmr::vector<VertexId> adjacency_vertex_ids_;
+  std::pmr::vector<std::pmr::vector<VertexId>> depth_list_;
+  std::pmr::vector<Edge> edges_;
+  // Only kept for graphs created on the heap, see freeze(). The others scan
+  // the shorter adjacency list while they are mutable. Copies and moves carry
+  // the flag along with the set.
+  std::pmr::unordered_set<std::uint64_t> edge_keys_;
+  bool has_edge_keys_ = true;
+  bool frozen_ = false;
 
   VertexId vertex_id_counter_ = 0;
   EdgeId edge_id_counter_ = 0;
   VertexId get_new_vertex_id() { return vertex_id_counter_++; }
   EdgeId get_new_edge_id() { return edge_id_counter_++; }
 
+  static std::uint64_t get_edge_key(VertexId first_vertex_id,
+                                    VertexId second_vertex_id);
+
+  void build_adjacency_vertex_ids();
+
   Edge::Color calculate_edge_color(VertexId from_vertex_id,
                                    VertexId to_vertex_id) const;
 };
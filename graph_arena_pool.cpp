@@ -0,0 +1,94 @@
+#include "graph_arena_pool.hpp"
+#include <cstddef>
+#include <optional>
+
+namespace {
+// Spare room on top of the bytes allocated last time, for alignment padding.
+static constexpr std::size_t kBufferSlackDivisor = 8;
+}  // namespace
+
+namespace uni_course_cpp {
+
+class GraphArenaPool::Arena : public std::pmr::memory_resource {
+ public:
+  Arena() { resource_.emplace(); }
+
+  // Frees everything at once. If the buffer overflowed since the last reset,
+  // it's replaced by one that fits as much.
+  void reset() {
+    resource_.reset();
+    if (allocated_bytes_ > buffer_size_) {
+      buffer_size_ = allocated_bytes_ + allocated_bytes_ / kBufferSlackDivisor;
+      buffer_.reset();
+      buffer_ = std::make_unique<std::byte[]>(buffer_size_);
+    }
+    allocated_bytes_ = 0;
+    if (buffer_ == nullptr) {
+      resource_.emplace();
+    } else {
+      resource_.emplace(buffer_.get(), buffer_size_);
+    }
+  }
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    allocated_bytes_ += bytes;
+    return resource_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* pointer,
+                     std::size_t bytes,
+                     std::size_t alignment) override {
+    resource_->deallocate(pointer, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::unique_ptr<std::byte[]> buffer_;
+  std::size_t buffer_size_ = 0;
+  std::size_t allocated_bytes_ = 0;
+  std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+GraphArenaPool::GraphArenaPool(std::size_t max_arenas_count)
+    : max_arenas_count_(max_arenas_count) {}
+
+GraphArenaPool::~GraphArenaPool() = default;
+
+std::shared_ptr<std::pmr::memory_resource> GraphArenaPool::acquire() {
+  Arena* arena = nullptr;
+  {
+    std::unique_lock lock(mutex_);
+    arena_released_.wait(lock, [this]() {
+      return !free_arenas_.empty() || max_arenas_count_ == kNoArenasLimit ||
+             arenas_.size() < max_arenas_count_;
+    });
+    if (free_arenas_.empty()) {
+      arena = arenas_.emplace_back(std::make_unique<Arena>()).get();
+    } else {
+      arena = free_arenas_.back();
+      free_arenas_.pop_back();
+    }
+  }
+  return std::shared_ptr<std::pmr::memory_resource>(
+      arena, [pool = shared_from_this()](std::pmr::memory_resource* resource) {
+        pool->release(static_cast<Arena*>(resource));
+      });
+}
+
+std::size_t GraphArenaPool::arenas_count() const {
+  const std::lock_guard lock(mutex_);
+  return arenas_.size();
+}
+
+void GraphArenaPool::release(Arena* arena) {
+  arena->reset();
+  const std::lock_guard lock(mutex_);
+  free_arenas_.push_back(arena);
+  arena_released_.notify_one();
+}
+
+}  // namespace uni_course_cpp
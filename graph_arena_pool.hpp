@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace uni_course_cpp {
+
+// Hands out monotonic arenas for graphs. Allocating from an arena is a pointer
+// bump, and a graph's memory is released at once when the last pointer to its
+// arena goes away, the arena then comes back here for the next graph. Arenas
+// keep their buffer, grown to the most they held so far, so a reused arena
+// rarely goes to the global heap. An arena isn't synchronized, only one thread
+// at a time may allocate from it.
+class GraphArenaPool : public std::enable_shared_from_this<GraphArenaPool> {
+ public:
+  static constexpr std::size_t kNoArenasLimit = 0;
+
+  // With a limit, acquire() waits for a free arena once `max_arenas_count` of
+  // them exist, which caps how many graphs built in the pool are alive.
+  explicit GraphArenaPool(std::size_t max_arenas_count = kNoArenasLimit);
+  ~GraphArenaPool();
+  GraphArenaPool(const GraphArenaPool&) = delete;
+  GraphArenaPool& operator=(const GraphArenaPool&) = delete;
+
+  // The pool must be owned by a shared_ptr, handed out arenas keep it alive.
+  // Blocks while every arena is handed out and no more may be created.
+  std::shared_ptr<std::pmr::memory_resource> acquire();
+
+  // Arenas created so far, both handed out and free.
+  std::size_t arenas_count() const;
+
+ private:
+  class Arena;
+
+  void release(Arena* arena);
+
+  const std::size_t max_arenas_count_;
+  mutable std::mutex mutex_;
+  std::condition_variable arena_released_;
+  std::vector<std::unique_ptr<Arena>> arenas_;
+  std::vector<Arena*> free_arenas_;
+};
+
+}  // namespace uni_course_cpp
@@ -0,0 +1,269 @@
+#include "graph_bfs.hpp"
+#include <algorithm>
+#include <cassert>
+#include "thread_pool.hpp"
+
+namespace {
+using Word = std::uint64_t;
+
+static constexpr std::size_t kWordBits = 64;
+static constexpr Word kFullWord = ~Word(0);
+// Direction switch thresholds from Beamer et al., "Direction-Optimizing
+// Breadth-First Search".
+static constexpr std::size_t kTopDownToBottomUpRatio = 14;
+static constexpr std::size_t kBottomUpToTopDownRatio = 24;
+static constexpr std::size_t kWordsPerBottomUpTask = 1 << 10;
+
+std::size_t get_words_count(std::size_t bits_count) {
+  return (bits_count + kWordBits - 1) / kWordBits;
+}
+
+bool test_bit(const std::vector<Word>& bitset, std::size_t index) {
+  return (bitset[index / kWordBits] >> (index % kWordBits)) & 1;
+}
+
+void set_bit(std::vector<Word>& bitset, std::size_t index) {
+  bitset[index / kWordBits] |= Word(1) << (index % kWordBits);
+}
+
+template <typename Visitor>
+void for_each_set_bit(Word word, std::size_t word_index, Visitor&& visit) {
+  while (word != 0) {
+    visit(word_index * kWordBits + __builtin_ctzll(word));
+    word &= word - 1;
+  }
+}
+
+void build_csr(std::size_t vertices_count,
+               const std::vector<std::pair<uni_course_cpp::Graph::VertexId,
+                                           uni_course_cpp::Graph::VertexId>>&
+                   arcs,
+               std::vector<std::size_t>& offsets,
+               std::vector<uni_course_cpp::Graph::VertexId>& vertex_ids) {
+  offsets.assign(vertices_count + 1, 0);
+  for (const auto& [from_vertex_id, to_vertex_id] : arcs) {
+    offsets[from_vertex_id + 1]++;
+  }
+  for (std::size_t i = 0; i < vertices_count; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  vertex_ids.resize(arcs.size());
+  auto positions = std::vector<std::size_t>(offsets.begin(), offsets.end() - 1);
+  for (const auto& [from_vertex_id, to_vertex_id] : arcs) {
+    vertex_ids[positions[from_vertex_id]++] = to_vertex_id;
+  }
+}
+}  // namespace
+
+namespace uni_course_cpp {
+
+GraphBfs::GraphBfs(const Graph& graph, EdgeDirection direction)
+    : graph_(graph),
+      direction_(direction),
+      vertices_count_(graph.get_vertices().size()) {
+  assert(graph.is_frozen() && "Graph isn't frozen");
+  auto arcs = std::vector<std::pair<Graph::VertexId, Graph::VertexId>>();
+  arcs.reserve(2 * graph.get_edges().size());
+  for (const auto& edge : graph.get_edges()) {
+    if (edge.from_vertex_id == edge.to_vertex_id) {
+      continue;
+    }
+    arcs.emplace_back(edge.from_vertex_id, edge.to_vertex_id);
+    if (direction_ == EdgeDirection::Both) {
+      arcs.emplace_back(edge.to_vertex_id, edge.from_vertex_id);
+    }
+  }
+  build_csr(vertices_count_, arcs, out_offsets_, out_vertex_ids_);
+  if (direction_ == EdgeDirection::Forward) {
+    for (auto& [from_vertex_id, to_vertex_id] : arcs) {
+      std::swap(from_vertex_id, to_vertex_id);
+    }
+    build_csr(vertices_count_, arcs, in_offsets_, in_vertex_ids_);
+  }
+  const auto words_count = get_words_count(vertices_count_);
+  visited_.resize(words_count);
+  frontier_.resize(words_count);
+  next_frontier_.resize(words_count);
+}
+
+Graph::IdsView<Graph::VertexId> GraphBfs::get_in_vertex_ids(
+    Graph::VertexId vertex_id) const {
+  if (direction_ == EdgeDirection::Both) {
+    return get_out_vertex_ids(vertex_id);
+  }
+  return Graph::IdsView<Graph::VertexId>(
+      in_vertex_ids_.data() + in_offsets_[vertex_id],
+      in_vertex_ids_.data() + in_offsets_[vertex_id + 1]);
+}
+
+std::vector<int> GraphBfs::get_hop_distances(Graph::VertexId source_vertex_id) {
+  assert(graph_.has_vertex(source_vertex_id) && "Source vertex doesn't exist");
+  auto hop_distances = std::vector<int>(vertices_count_, kUnreachable);
+  reset();
+  add_source(source_vertex_id, hop_distances.data());
+  run(hop_distances.data());
+  return hop_distances;
+}
+
+std::size_t GraphBfs::count_reachable_vertices(const DepthRange& from,
+                                               const DepthRange& to) {
+  assert(from.min_depth >= kGraphDefaultDepth &&
+         from.min_depth <= from.max_depth &&
+         from.max_depth <= graph_.get_depth() && "Invalid source depths");
+  assert(to.min_depth >= kGraphDefaultDepth && to.min_depth <= to.max_depth &&
+         to.max_depth <= graph_.get_depth() && "Invalid target depths");
+  reset();
+  for (auto depth = from.min_depth; depth <= from.max_depth; depth++) {
+    for (const auto vertex_id : graph_.vertex_ids_at_depth(depth)) {
+      add_source(vertex_id, nullptr);
+    }
+  }
+  run(nullptr);
+
+  std::size_t reachable_count = 0;
+  for (auto depth = to.min_depth; depth <= to.max_depth; depth++) {
+    for (const auto vertex_id : graph_.vertex_ids_at_depth(depth)) {
+      reachable_count += test_bit(visited_, vertex_id);
+    }
+  }
+  return reachable_count;
+}
+
+void GraphBfs::reset() {
+  std::fill(visited_.begin(), visited_.end(), 0);
+  std::fill(frontier_.begin(), frontier_.end(), 0);
+  // Bits past the last vertex are marked visited, so that the bottom-up step
+  // never treats them as vertices.
+  if (vertices_count_ % kWordBits != 0) {
+    visited_.back() = kFullWord << (vertices_count_ % kWordBits);
+  }
+  frontier_vertices_count_ = 0;
+  frontier_edges_count_ = 0;
+  unexplored_edges_count_ = out_vertex_ids_.size();
+}
+
+void GraphBfs::add_source(Graph::VertexId vertex_id, int* hop_distances) {
+  if (test_bit(visited_, vertex_id)) {
+    return;
+  }
+  set_bit(visited_, vertex_id);
+  set_bit(frontier_, vertex_id);
+  if (hop_distances != nullptr) {
+    hop_distances[vertex_id] = 0;
+  }
+  frontier_vertices_count_++;
+  frontier_edges_count_ += get_out_degree(vertex_id);
+}
+
+void GraphBfs::run(int* hop_distances) {
+  bool is_bottom_up = false;
+  for (int hop = 1; frontier_vertices_count_ > 0; hop++) {
+    unexplored_edges_count_ -= frontier_edges_count_;
+    if (is_bottom_up) {
+      is_bottom_up = frontier_vertices_count_ * kBottomUpToTopDownRatio >=
+                     vertices_count_;
+    } else {
+      is_bottom_up = frontier_edges_count_ * kTopDownToBottomUpRatio >
+                     unexplored_edges_count_;
+    }
+    const auto step = is_bottom_up ? expand_bottom_up(hop_distances, hop)
+                                   : expand_top_down(hop_distances, hop);
+    frontier_.swap(next_frontier_);
+    frontier_vertices_count_ = step.vertices_count;
+    frontier_edges_count_ = step.edges_count;
+  }
+}
+
+GraphBfs::StepResult GraphBfs::expand_top_down(int* hop_distances, int hop) {
+  auto step = StepResult();
+  std::fill(next_frontier_.begin(), next_frontier_.end(), 0);
+  for (std::size_t i = 0; i < frontier_.size(); i++) {
+    if (frontier_[i] == 0) {
+      continue;
+    }
+    for_each_set_bit(frontier_[i], i, [&](Graph::VertexId vertex_id) {
+      for (const auto next_vertex_id : get_out_vertex_ids(vertex_id)) {
+        // One load of the visited word both tests and marks the vertex.
+        auto& visited_word = visited_[next_vertex_id / kWordBits];
+        const auto bit = Word(1) << (next_vertex_id % kWordBits);
+        if ((visited_word & bit) != 0) {
+          continue;
+        }
+        visited_word |= bit;
+        next_frontier_[next_vertex_id / kWordBits] |= bit;
+        if (hop_distances != nullptr) {
+          hop_distances[next_vertex_id] = hop;
+        }
+        step.vertices_count++;
+        step.edges_count += get_out_degree(next_vertex_id);
+      }
+    });
+  }
+  return step;
+}
+
+GraphBfs::StepResult GraphBfs::expand_bottom_up(int* hop_distances, int hop) {
+  const auto words_count = visited_.size();
+  if (words_count < 2 * kWordsPerBottomUpTask) {
+    return expand_bottom_up_words(hop_distances, hop, 0, words_count);
+  }
+  // Every task owns a range of words, so it writes its part of the next
+  // frontier and of the distances without synchronization.
+  const auto tasks_count =
+      (words_count + kWordsPerBottomUpTask - 1) / kWordsPerBottomUpTask;
+  auto task_steps = std::vector<StepResult>(tasks_count);
+  TaskGroup step_tasks;
+  for (std::size_t i = 0; i < tasks_count; i++) {
+    step_tasks.run([this, hop_distances, hop, i, words_count,
+                    &step = task_steps[i]]() {
+      const auto begin_word = i * kWordsPerBottomUpTask;
+      step = expand_bottom_up_words(
+          hop_distances, hop, begin_word,
+          std::min(begin_word + kWordsPerBottomUpTask, words_count));
+    });
+  }
+  step_tasks.wait();
+
+  auto step = StepResult();
+  for (const auto& task_step : task_steps) {
+    step.vertices_count += task_step.vertices_count;
+    step.edges_count += task_step.edges_count;
+  }
+  return step;
+}
+
+GraphBfs::StepResult GraphBfs::expand_bottom_up_words(int* hop_distances,
+                                                      int hop,
+                                                      std::size_t begin_word,
+                                                      std::size_t end_word) {
+  auto step = StepResult();
+  for (auto i = begin_word; i < end_word; i++) {
+    // Only the unvisited vertices of a word look for parents, fully visited
+    // words cost a single load. Parents are read from `frontier_` only, so
+    // the task marks its own words visited right away.
+    const auto unvisited_word = ~visited_[i];
+    Word next_word = 0;
+    for_each_set_bit(unvisited_word, i, [&](Graph::VertexId vertex_id) {
+      for (const auto parent_vertex_id : get_in_vertex_ids(vertex_id)) {
+        if (test_bit(frontier_, parent_vertex_id)) {
+          next_word |= Word(1) << (vertex_id % kWordBits);
+          step.edges_count += get_out_degree(vertex_id);
+          break;
+        }
+      }
+    });
+    next_frontier_[i] = next_word;
+    visited_[i] |= next_word;
+    if (next_word == 0) {
+      continue;
+    }
+    step.vertices_count += __builtin_popcountll(next_word);
+    if (hop_distances != nullptr) {
+      for_each_set_bit(next_word, i, [&](Graph::VertexId vertex_id) {
+        hop_distances[vertex_id] = hop;
+      });
+    }
+  }
+  return step;
+}
+}  // namespace uni_course_cpp
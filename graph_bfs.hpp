@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "graph.hpp"
+
+namespace uni_course_cpp {
+// Level-synchronous BFS with dense bitset frontiers. Narrow levels are
+// expanded top-down from the frontier, wide ones bottom-up: every unvisited
+// vertex looks for a parent in the frontier, split by bitset words across the
+// ThreadPool. Both steps walk the bitsets a 64-bit word at a time, skip empty
+// words and find set bits with ctz; only the adjacency lists, which have no
+// word-wide form, are read vertex by vertex. Scratch bitsets are kept between
+// queries, an instance must not be shared between threads.
+class GraphBfs {
+ public:
+  enum class EdgeDirection { Both, Forward };
+
+  struct DepthRange {
+    Graph::Depth min_depth = kGraphDefaultDepth;
+    Graph::Depth max_depth = kGraphDefaultDepth;
+  };
+
+  static constexpr int kUnreachable = -1;
+
+  // With `EdgeDirection::Forward` edges are only followed from
+  // `from_vertex_id` to `to_vertex_id`, that is towards deeper levels.
+  explicit GraphBfs(const Graph& graph,
+                    EdgeDirection direction = EdgeDirection::Both);
+
+  // Hop distance from `source_vertex_id` to every vertex, kUnreachable for
+  // vertices that can't be reached.
+  std::vector<int> get_hop_distances(Graph::VertexId source_vertex_id = 0);
+
+  // Number of vertices at depths of `to` that can be reached from at least
+  // one vertex at depths of `from`.
+  std::size_t count_reachable_vertices(const DepthRange& from,
+                                       const DepthRange& to);
+
+ private:
+  using Word = std::uint64_t;
+  using Bitset = std::vector<Word>;
+
+  struct StepResult {
+    std::size_t vertices_count = 0;
+    std::size_t edges_count = 0;
+  };
+
+  Graph::IdsView<Graph::VertexId> get_out_vertex_ids(
+      Graph::VertexId vertex_id) const {
+    return Graph::IdsView<Graph::VertexId>(
+        out_vertex_ids_.data() + out_offsets_[vertex_id],
+        out_vertex_ids_.data() + out_offsets_[vertex_id + 1]);
+  }
+
+  Graph::IdsView<Graph::VertexId> get_in_vertex_ids(
+      Graph::VertexId vertex_id) const;
+
+  std::size_t get_out_degree(Graph::VertexId vertex_id) const {
+    return out_offsets_[vertex_id + 1] - out_offsets_[vertex_id];
+  }
+
+  void reset();
+
+  void add_source(Graph::VertexId vertex_id, int* hop_distances);
+
+  // Expands the sources added since the last reset() until the frontier is
+  // empty. `hop_distances` may be null.
+  void run(int* hop_distances);
+
+  StepResult expand_top_down(int* hop_distances, int hop);
+
+  StepResult expand_bottom_up(int* hop_distances, int hop);
+
+  StepResult expand_bottom_up_words(int* hop_distances,
+                                    int hop,
+                                    std::size_t begin_word,
+                                    std::size_t end_word);
+
+  const Graph& graph_;
+  EdgeDirection direction_;
+  std::size_t vertices_count_ = 0;
+  std::vector<std::size_t> out_offsets_;
+  std::vector<Graph::VertexId> out_vertex_ids_;
+  std::vector<std::size_t> in_offsets_;
+  std::vector<Graph::VertexId> in_vertex_ids_;
+  Bitset visited_;
+  Bitset frontier_;
+  Bitset next_frontier_;
+  std::size_t frontier_vertices_count_ = 0;
+  std::size_t frontier_edges_count_ = 0;
+  std::size_t unexplored_edges_count_ = 0;
+};
+}  // namespace uni_course_cpp
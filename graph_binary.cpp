@@ -0,0 +1,302 @@
+#include "graph_binary.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "output_buffer.hpp"
+
+namespace {
+
+static constexpr char kFileMagic[8] = {'U', 'C', 'G', 'R', 'A', 'P', 'H', '\0'};
+static constexpr std::uint32_t kFileVersion = 1;
+static constexpr std::uint64_t kSectionAlignment = 8;
+static constexpr int kFilePermissions = 0644;
+static constexpr std::uint8_t kColorsCount =
+    static_cast<std::uint8_t>(uni_course_cpp::Graph::Edge::Color::Red) + 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::int32_t depth;
+  std::uint64_t vertices_count;
+  std::uint64_t edges_count;
+  std::uint64_t adjacency_size;
+  std::uint64_t vertex_depths_offset;
+  std::uint64_t adjacency_offsets_offset;
+  std::uint64_t adjacency_edge_ids_offset;
+  std::uint64_t depth_offsets_offset;
+  std::uint64_t depth_vertex_ids_offset;
+  std::uint64_t edge_vertex_ids_offset;
+  std::uint64_t edge_colors_offset;
+  std::uint64_t file_size;
+};
+
+std::uint64_t align_offset(std::uint64_t offset) {
+  return (offset + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+FileHeader get_file_header(const uni_course_cpp::Graph& graph) {
+  FileHeader header{};
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kFileVersion;
+  header.depth = graph.get_depth();
+  header.vertices_count = graph.get_vertices().size();
+  header.edges_count = graph.get_edges().size();
+  for (const auto& vertex : graph.get_vertices()) {
+    header.adjacency_size +=
+        graph.edge_ids_connected_to_vertex(vertex.id).size();
+  }
+
+  std::uint64_t offset = align_offset(sizeof(FileHeader));
+  const auto add_section = [&offset](std::uint64_t bytes_count) {
+    const auto section_offset = offset;
+    offset = align_offset(offset + bytes_count);
+    return section_offset;
+  };
+  header.vertex_depths_offset =
+      add_section(header.vertices_count * sizeof(uni_course_cpp::Graph::Depth));
+  header.adjacency_offsets_offset =
+      add_section((header.vertices_count + 1) * sizeof(std::uint64_t));
+  header.adjacency_edge_ids_offset = add_section(
+      header.adjacency_size * sizeof(uni_course_cpp::Graph::EdgeId));
+  header.depth_offsets_offset =
+      add_section((header.depth + 1) * sizeof(std::uint64_t));
+  header.depth_vertex_ids_offset = add_section(
+      header.vertices_count * sizeof(uni_course_cpp::Graph::VertexId));
+  header.edge_vertex_ids_offset = add_section(
+      2 * header.edges_count * sizeof(uni_course_cpp::Graph::VertexId));
+  header.edge_colors_offset =
+      add_section(header.edges_count * sizeof(std::uint8_t));
+  header.file_size = offset;
+  return header;
+}
+
+class SectionWriter {
+ public:
+  explicit SectionWriter(uni_course_cpp::printing::OutputBuffer& output)
+      : output_(output) {}
+
+  template <typename Value>
+  void write(const Value& value) {
+    output_.write(std::string_view(reinterpret_cast<const char*>(&value),
+                                   sizeof(Value)));
+    offset_ += sizeof(Value);
+  }
+
+  void seek(std::uint64_t offset) {
+    if (offset < offset_) {
+      throw std::logic_error("Graph file sections overlap");
+    }
+    for (; offset_ < offset; offset_++) {
+      output_.write('\0');
+    }
+  }
+
+ private:
+  uni_course_cpp::printing::OutputBuffer& output_;
+  std::uint64_t offset_ = 0;
+};
+
+std::runtime_error get_file_error(const std::string& filename,
+                                  const std::string& reason) {
+  return std::runtime_error("Invalid graph file " + filename + ": " + reason);
+}
+
+template <typename Value>
+const Value* get_section(const uni_course_cpp::MappedFile& file,
+                         std::uint64_t offset,
+                         std::uint64_t values_count,
+                         const std::string& filename) {
+  if (offset % alignof(Value) != 0 || offset > file.size() ||
+      values_count > (file.size() - offset) / sizeof(Value)) {
+    throw get_file_error(filename, "section is out of bounds");
+  }
+  return reinterpret_cast<const Value*>(file.data() + offset);
+}
+
+// Offsets of a CSR-like section: start at 0, never decrease and end at
+// `values_count`, so every range they delimit is inside the values section.
+bool are_offsets_valid(const std::uint64_t* offsets,
+                       std::uint64_t offsets_count,
+                       std::uint64_t values_count) {
+  if (offsets[0] != 0 || offsets[offsets_count - 1] != values_count) {
+    return false;
+  }
+  for (std::uint64_t i = 1; i < offsets_count; i++) {
+    if (offsets[i] < offsets[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Value>
+bool are_values_in_range(const Value* values,
+                         std::uint64_t values_count,
+                         std::int64_t min_value,
+                         std::int64_t max_value) {
+  for (std::uint64_t i = 0; i < values_count; i++) {
+    if (values[i] < min_value || values[i] > max_value) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+namespace uni_course_cpp {
+namespace binary {
+
+void write_graph_to_file(const Graph& graph, const std::string& filename) {
+  const auto header = get_file_header(graph);
+  const int file_descriptor =
+      ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, kFilePermissions);
+  if (file_descriptor < 0) {
+    throw std::runtime_error("Failed to open " + filename + ": " +
+                             std::strerror(errno));
+  }
+  try {
+    printing::OutputBuffer output(file_descriptor);
+    SectionWriter writer(output);
+    writer.write(header);
+
+    writer.seek(header.vertex_depths_offset);
+    for (const auto& vertex : graph.get_vertices()) {
+      writer.write(graph.get_vertex_depth(vertex.id));
+    }
+
+    writer.seek(header.adjacency_offsets_offset);
+    std::uint64_t adjacency_offset = 0;
+    writer.write(adjacency_offset);
+    for (const auto& vertex : graph.get_vertices()) {
+      adjacency_offset += graph.edge_ids_connected_to_vertex(vertex.id).size();
+      writer.write(adjacency_offset);
+    }
+
+    writer.seek(header.adjacency_edge_ids_offset);
+    for (const auto& vertex : graph.get_vertices()) {
+      for (const auto edge_id : graph.edge_ids_connected_to_vertex(vertex.id)) {
+        writer.write(edge_id);
+      }
+    }
+
+    writer.seek(header.depth_offsets_offset);
+    std::uint64_t depth_offset = 0;
+    writer.write(depth_offset);
+    for (Graph::Depth depth = kGraphDefaultDepth; depth <= header.depth;
+         depth++) {
+      depth_offset += graph.vertex_ids_at_depth(depth).size();
+      writer.write(depth_offset);
+    }
+
+    writer.seek(header.depth_vertex_ids_offset);
+    for (Graph::Depth depth = kGraphDefaultDepth; depth <= header.depth;
+         depth++) {
+      for (const auto vertex_id : graph.vertex_ids_at_depth(depth)) {
+        writer.write(vertex_id);
+      }
+    }
+
+    writer.seek(header.edge_vertex_ids_offset);
+    for (const auto& edge : graph.get_edges()) {
+      writer.write(edge.from_vertex_id);
+      writer.write(edge.to_vertex_id);
+    }
+
+    writer.seek(header.edge_colors_offset);
+    for (const auto& edge : graph.get_edges()) {
+      writer.write(static_cast<std::uint8_t>(edge.color));
+    }
+    writer.seek(header.file_size);
+    output.flush();
+  } catch (...) {
+    ::close(file_descriptor);
+    throw;
+  }
+  ::close(file_descriptor);
+}
+
+MappedGraph::MappedGraph(const std::string& filename) : file_(filename) {
+  if (file_.size() < sizeof(FileHeader)) {
+    throw get_file_error(filename, "file is too small");
+  }
+  FileHeader header;
+  std::memcpy(&header, file_.data(), sizeof(FileHeader));
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+    throw get_file_error(filename, "wrong magic");
+  }
+  if (header.version != kFileVersion) {
+    throw get_file_error(
+        filename, "unsupported version " + std::to_string(header.version));
+  }
+  // Ids are ints, larger counts can't come from write_graph_to_file.
+  if (header.file_size != file_.size() || header.depth < 0 ||
+      header.vertices_count > std::numeric_limits<Graph::VertexId>::max() ||
+      header.edges_count > std::numeric_limits<Graph::EdgeId>::max()) {
+    throw get_file_error(filename, "header doesn't match the file");
+  }
+  depth_ = header.depth;
+  vertices_count_ = header.vertices_count;
+  edges_count_ = header.edges_count;
+  vertex_depths_ = get_section<Graph::Depth>(
+      file_, header.vertex_depths_offset, vertices_count_, filename);
+  adjacency_offsets_ = get_section<std::uint64_t>(
+      file_, header.adjacency_offsets_offset, vertices_count_ + 1, filename);
+  adjacency_edge_ids_ = get_section<Graph::EdgeId>(
+      file_, header.adjacency_edge_ids_offset, header.adjacency_size,
+      filename);
+  depth_offsets_ = get_section<std::uint64_t>(
+      file_, header.depth_offsets_offset, depth_ + 1, filename);
+  depth_vertex_ids_ = get_section<Graph::VertexId>(
+      file_, header.depth_vertex_ids_offset, vertices_count_, filename);
+  edge_vertex_ids_ = get_section<Graph::VertexId>(
+      file_, header.edge_vertex_ids_offset, 2 * edges_count_, filename);
+  edge_colors_ = get_section<std::uint8_t>(file_, header.edge_colors_offset,
+                                           edges_count_, filename);
+  if (!are_offsets_valid(adjacency_offsets_, vertices_count_ + 1,
+                         header.adjacency_size) ||
+      !are_offsets_valid(depth_offsets_, depth_ + 1, vertices_count_)) {
+    throw get_file_error(filename, "section sizes don't match the header");
+  }
+  const auto max_vertex_id = static_cast<std::int64_t>(vertices_count_) - 1;
+  const auto max_edge_id = static_cast<std::int64_t>(edges_count_) - 1;
+  if (!are_values_in_range(vertex_depths_, vertices_count_, kGraphDefaultDepth,
+                           depth_) ||
+      !are_values_in_range(adjacency_edge_ids_, header.adjacency_size, 0,
+                           max_edge_id) ||
+      !are_values_in_range(depth_vertex_ids_, vertices_count_, 0,
+                           max_vertex_id) ||
+      !are_values_in_range(edge_vertex_ids_, 2 * edges_count_, 0,
+                           max_vertex_id) ||
+      !are_values_in_range(edge_colors_, edges_count_, 0, kColorsCount - 1)) {
+    throw get_file_error(filename, "id or depth out of range");
+  }
+}
+
+Graph MappedGraph::to_graph() const {
+  auto parts = Graph::FrozenParts();
+  parts.vertex_depths.assign(vertex_depths_, vertex_depths_ + vertices_count_);
+  parts.adjacency_offsets.assign(adjacency_offsets_,
+                                 adjacency_offsets_ + vertices_count_ + 1);
+  parts.adjacency_edge_ids.assign(
+      adjacency_edge_ids_,
+      adjacency_edge_ids_ + adjacency_offsets_[vertices_count_]);
+  parts.depth_list.reserve(depth_);
+  for (Graph::Depth depth = kGraphDefaultDepth; depth <= depth_; depth++) {
+    const auto vertex_ids = vertex_ids_at_depth(depth);
+    parts.depth_list.emplace_back(vertex_ids.begin(), vertex_ids.end());
+  }
+  parts.edges.reserve(edges_count_);
+  for (std::size_t edge_id = 0; edge_id < edges_count_; edge_id++) {
+    parts.edges.push_back(get_edge(edge_id));
+  }
+  return Graph(std::move(parts));
+}
+
+}  // namespace binary
+}  // namespace uni_course_cpp
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "graph.hpp"
+#include "mapped_file.hpp"
+
+namespace uni_course_cpp {
+namespace binary {
+
+// Layout of a graph file: a header followed by 8-byte aligned sections with
+// vertex depths, CSR adjacency, vertex ids grouped by depth, edge endpoints
+// and one byte per edge color. Values are stored in native byte order.
+void write_graph_to_file(const Graph& graph, const std::string& filename);
+
+// Read-only view of a graph file. The file is memory-mapped and the accessors
+// read straight from the mapping, nothing is copied on load. Offsets, ids,
+// depths and colors are validated once when the file is opened, so a corrupt
+// file throws instead of making the accessors read out of bounds.
+class MappedGraph {
+ public:
+  explicit MappedGraph(const std::string& filename);
+
+  int get_depth() const { return depth_; }
+
+  std::size_t vertices_count() const { return vertices_count_; }
+
+  std::size_t edges_count() const { return edges_count_; }
+
+  Graph::Depth get_vertex_depth(Graph::VertexId vertex_id) const {
+    return vertex_depths_[vertex_id];
+  }
+
+  Graph::IdsView<Graph::EdgeId> edge_ids_connected_to_vertex(
+      Graph::VertexId vertex_id) const {
+    return Graph::IdsView<Graph::EdgeId>(
+        adjacency_edge_ids_ + adjacency_offsets_[vertex_id],
+        adjacency_edge_ids_ + adjacency_offsets_[vertex_id + 1]);
+  }
+
+  Graph::IdsView<Graph::VertexId> vertex_ids_at_depth(
+      Graph::Depth depth) const {
+    const auto depth_index = depth - kGraphDefaultDepth;
+    return Graph::IdsView<Graph::VertexId>(
+        depth_vertex_ids_ + depth_offsets_[depth_index],
+        depth_vertex_ids_ + depth_offsets_[depth_index + 1]);
+  }
+
+  Graph::Edge get_edge(Graph::EdgeId edge_id) const {
+    return Graph::Edge(edge_id, edge_vertex_ids_[2 * edge_id],
+                       edge_vertex_ids_[2 * edge_id + 1],
+                       static_cast<Graph::Edge::Color>(edge_colors_[edge_id]));
+  }
+
+  // Copies the mapped sections into a frozen Graph, for code that needs a
+  // Graph. Use the accessors above to read the file without copying.
+  Graph to_graph() const;
+
+ private:
+  MappedFile file_;
+  int depth_ = 0;
+  std::size_t vertices_count_ = 0;
+  std::size_t edges_count_ = 0;
+  const Graph::Depth* vertex_depths_ = nullptr;
+  const std::uint64_t* adjacency_offsets_ = nullptr;
+  const Graph::EdgeId* adjacency_edge_ids_ = nullptr;
+  const std::uint64_t* depth_offsets_ = nullptr;
+  const Graph::VertexId* depth_vertex_ids_ = nullptr;
+  const Graph::VertexId* edge_vertex_ids_ = nullptr;
+  const std::uint8_t* edge_colors_ = nullptr;
+};
+
+}  // namespace binary
+}  // namespace uni_course_cpp
@@ -1,95 +1,171 @@
 #include "graph_generation_controller.hpp"
+#include <algorithm>
 #include <atomic>
-#include <cassert>
-#include <iostream>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include "tracer.hpp"
+
+namespace {
+
+static constexpr std::uint64_t kGraphSeedStream = 0;
+
+uni_course_cpp::GraphGenerator::Params get_graph_params(
+    const uni_course_cpp::GraphGenerator::Params& params,
+    int graph_index) {
+  const auto graph_seed =
+      uni_course_cpp::RandomStream(params.seed(), kGraphSeedStream)
+          .get(graph_index);
+  return uni_course_cpp::GraphGenerator::Params(
+      params.depth(), params.new_vertices_count(), graph_seed);
+}
+}  // namespace
 
 namespace uni_course_cpp {
 
 GraphGenerationController::GraphGenerationController(
     int threads_count,
     int graphs_count,
-    GraphGenerator::Params&& graph_generator_params)
+    GraphGenerator::Params&& graph_generator_params,
+    int max_graphs_in_flight)
     : threads_count_(threads_count),
       graphs_count_(graphs_count),
-      graph_generator_(std::move(graph_generator_params)) {
-  Worker::GetJobCallback get_job_callback =
-      [&jobs_ = jobs_,
-       &job_mutex_ = job_mutex_]() -> std::optional<JobCallback> {
-    const std::lock_guard lock(job_mutex_);
-    if (!jobs_.empty()) {
-      auto job = jobs_.front();
-      jobs_.pop_front();
-      return job;
-    }
-    return std::nullopt;
-  };
+      max_graphs_in_flight_(
+          std::max(max_graphs_in_flight, kNoGraphsInFlightLimit)),
+      lanes_count_(std::min({std::max(threads_count_, 1),
+                             ThreadPool::get_thread_pool().threads_count(),
+                             graphs_count_})),
+      graph_generator_params_(std::move(graph_generator_params)),
+      lane_jobs_counts_(lanes_count_),
+      initial_thread_pool_stats_(ThreadPool::get_thread_pool().get_stats()),
+      graph_arena_pool_(
+          std::make_shared<GraphArenaPool>(max_graphs_in_flight_)) {}
+
+void GraphGenerationController::add_jobs(const JobCallback& job) {
+  auto next_index = std::make_shared<std::atomic<int>>(0);
+  for (int i = 0; i < lanes_count_; i++) {
+    jobs_.run([this, job, next_index, &jobs_count = lane_jobs_counts_[i]]() {
+      for (int index = (*next_index)++; index < graphs_count_;
+           index = (*next_index)++) {
+        if (is_stopped_.load(std::memory_order_relaxed)) {
+          return;
+        }
+        // Counted before the job, so the count is complete once its graph
+        // is handed out.
+        jobs_count.fetch_add(1, std::memory_order_relaxed);
+        job(index);
+      }
+    });
+  }
+}
 
-  for (int i = 0; i < std::min(kMaxThreadsCount, threads_count_); i++) {
-    workers_.emplace_back(get_job_callback);
+std::unique_lock<std::mutex> GraphGenerationController::lock_callbacks() {
+  auto lock = std::unique_lock(callback_mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    return lock;
   }
+  const auto start = std::chrono::steady_clock::now();
+  lock.lock();
+  callback_wait_nanoseconds_.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count(),
+      std::memory_order_relaxed);
+  callback_waits_count_.fetch_add(1, std::memory_order_relaxed);
+  return lock;
+}
+
+GraphGenerationController::Stats GraphGenerationController::get_stats() {
+  auto stats = Stats();
+  {
+    const std::lock_guard lock(callback_mutex_);
+    stats.graphs = graphs_stats_;
+  }
+  stats.callback_wait_duration = std::chrono::nanoseconds(
+      callback_wait_nanoseconds_.load(std::memory_order_relaxed));
+  stats.callback_waits_count =
+      callback_waits_count_.load(std::memory_order_relaxed);
+  const auto thread_pool_stats = ThreadPool::get_thread_pool().get_stats();
+  stats.thread_pool.queue_wait_duration =
+      thread_pool_stats.queue_wait_duration -
+      initial_thread_pool_stats_.queue_wait_duration;
+  stats.thread_pool.queue_waits_count =
+      thread_pool_stats.queue_waits_count -
+      initial_thread_pool_stats_.queue_waits_count;
+  for (const auto& jobs_count : lane_jobs_counts_) {
+    stats.lane_jobs_counts.push_back(
+        jobs_count.load(std::memory_order_relaxed));
+  }
+  stats.arenas_count =
+      graph_arena_pool_->arenas_count() + branch_arena_pool_->arenas_count();
+  return stats;
 }
 
 void GraphGenerationController::generate(
     const GenStartedCallback& gen_started_callback,
     const GenFinishedCallback& gen_finished_callback) {
-  std::atomic<int> jobs_counter = graphs_count_;
-  std::mutex callback_mutex;
-  for (int i = 0; i < graphs_count_; i++) {
-    jobs_.emplace_back([&gen_started_callback, &gen_finished_callback,
-                        &jobs_counter, i, &graph_generator_ = graph_generator_,
-                        &callback_mutex]() {
+  // The first failure stops the lanes from taking new graphs, the callbacks
+  // are only borrowed, so every lane has to be done before returning.
+  add_jobs([this, &gen_started_callback, &gen_finished_callback](int index) {
+    const auto trace_scope = TraceScope("generation job", index);
+    try {
       {
-        const std::lock_guard lock(callback_mutex);
-        gen_started_callback(i);
+        const auto lock = lock_callbacks();
+        gen_started_callback(index);
       }
-      auto graph = graph_generator_.generate();
+      auto stats = GraphGenerator::Stats();
+      auto graph = GraphGenerator(get_graph_params(graph_generator_params_,
+                                                   index),
+                                  graph_arena_pool_, branch_arena_pool_)
+                       .generate(stats);
       {
-        const std::lock_guard lock(callback_mutex);
-        gen_finished_callback(i, std::move(graph));
+        const auto lock = lock_callbacks();
+        graphs_stats_ += stats;
       }
-      jobs_counter--;
-    });
-  }
-  for (auto& worker : workers_) {
-    worker.start();
-  }
-  while (jobs_counter != 0) {
-  }
-
-  for (auto& worker : workers_) {
-    worker.stop();
-  }
-}
-
-void GraphGenerationController::Worker::start() {
-  assert(state_ != State::Working && "Worker is already working");
-  state_ = State::Working;
-
-  thread_ =
-      std::thread([&state_ = state_, &get_job_callback_ = get_job_callback_]() {
-        while (true) {
-          if (state_ == State::ShouldTerminate) {
-            return;
-          }
-          const auto job_optional = get_job_callback_();
-          if (job_optional.has_value()) {
-            const auto& job = job_optional.value();
-            job();
-          }
-        }
-      });
-}
-
-void GraphGenerationController::Worker::stop() {
-  assert(state_ == State::Working && "Worker has been already stopped");
-
-  state_ = State::ShouldTerminate;
-  thread_.join();
+      gen_finished_callback(index, std::move(graph), stats);
+    } catch (...) {
+      is_stopped_.store(true, std::memory_order_relaxed);
+      throw;
+    }
+  });
+  jobs_.wait();
 }
 
-GraphGenerationController::Worker::~Worker() {
-  if (state_ == State::Working) {
-    stop();
+std::vector<std::future<Graph>> GraphGenerationController::generate_async(
+    const GenStartedCallback& gen_started_callback) {
+  if (max_graphs_in_flight_ != kNoGraphsInFlightLimit) {
+    throw std::runtime_error(
+        "Asynchronous generation can't limit the graphs in flight");
   }
+  auto promises =
+      std::make_shared<std::vector<std::promise<Graph>>>(graphs_count_);
+  auto futures = std::vector<std::future<Graph>>();
+  futures.reserve(graphs_count_);
+  for (auto& promise : *promises) {
+    futures.push_back(promise.get_future());
+  }
+  add_jobs([this, gen_started_callback, promises](int index) {
+    auto& promise = promises->at(index);
+    const auto trace_scope = TraceScope("generation job", index);
+    try {
+      {
+        const auto lock = lock_callbacks();
+        gen_started_callback(index);
+      }
+      auto stats = GraphGenerator::Stats();
+      auto graph = GraphGenerator(get_graph_params(graph_generator_params_,
+                                                   index),
+                                  graph_arena_pool_, branch_arena_pool_)
+                       .generate(stats);
+      {
+        const auto lock = lock_callbacks();
+        graphs_stats_ += stats;
+      }
+      promise.set_value(std::move(graph));
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  });
+  return futures;
 }
 }  // namespace uni_course_cpp
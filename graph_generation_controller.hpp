@@ -1,55 +1,101 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
-#include <list>
-#include <thread>
+#include <future>
+#include <mutex>
+#include <vector>
+#include "graph_arena_pool.hpp"
 #include "graph_generator.hpp"
-
-namespace {
-const int kMaxThreadsCount = std::thread::hardware_concurrency();
-}  // namespace
+#include "thread_pool.hpp"
 
 namespace uni_course_cpp {
 class GraphGenerationController {
  public:
   using GenStartedCallback = std::function<void(int index)>;
-  using GenFinishedCallback = std::function<void(int index, Graph&& graph)>;
+  using GenFinishedCallback = std::function<
+      void(int index, Graph&& graph, const GraphGenerator::Stats& stats)>;
 
-  GraphGenerationController(int threads_count,
-                            int graphs_count,
-                            GraphGenerator::Params&& graph_generator_params);
+  struct Stats {
+    // Summed over every graph generated so far.
+    GraphGenerator::Stats graphs;
+    // Time jobs spent blocked on the callback mutex another job held.
+    std::chrono::nanoseconds callback_wait_duration =
+        std::chrono::nanoseconds::zero();
+    std::uint64_t callback_waits_count = 0;
+    // Task queue contention of the whole pool while this controller ran,
+    // other users of the pool are counted too.
+    ThreadPool::Stats thread_pool;
+    // Graphs generated by every lane, see the constructor.
+    std::vector<int> lane_jobs_counts;
+    // Arenas created for graphs and their grey branches, the rest of the
+    // graphs reused one.
+    std::size_t arenas_count = 0;
+  };
 
-  void generate(const GenStartedCallback& gen_started_callback,
-                const GenFinishedCallback& gen_finished_callback);
+  static constexpr int kNoGraphsInFlightLimit = 0;
 
- private:
-  using JobCallback = std::function<void()>;
+  // At most `threads_count` graphs are generated at the same time, all of them
+  // share the process-wide ThreadPool. Graphs are handed out to that many
+  // lanes, fewer if the pool or the graphs count is smaller. Every graph is
+  // built in an arena of the controller's pool, reused once the graph is
+  // destroyed.
+  //
+  // With `max_graphs_in_flight`, at most that many graphs of the controller
+  // are alive at a time, counting the ones being generated: a lane waits to
+  // start a graph until an earlier one is destroyed. Memory then stays flat
+  // however many graphs are generated, as long as the callback hands graphs
+  // to someone who lets go of them.
+  GraphGenerationController(
+      int threads_count,
+      int graphs_count,
+      GraphGenerator::Params&& graph_generator_params,
+      int max_graphs_in_flight = kNoGraphsInFlightLimit);
 
-  class Worker {
-   public:
-    using GetJobCallback = std::function<std::optional<JobCallback>()>;
+  // `gen_started_callback` calls are serialized, `gen_finished_callback` is
+  // called without a lock so that it may block, e.g. on a full queue, without
+  // stalling the other lanes, and has to be thread-safe.
+  //
+  // Returns once every lane is done. If a graph or a callback throws, no new
+  // graphs are started and the first exception is rethrown.
+  void generate(const GenStartedCallback& gen_started_callback,
+                const GenFinishedCallback& gen_finished_callback);
 
-    explicit Worker(const GetJobCallback& get_job_callback)
-        : get_job_callback_(get_job_callback) {}
+  // Queues every graph and returns right away. The future of a graph becomes
+  // ready as soon as that graph is generated. Throws if the controller has a
+  // graphs in flight limit: graphs held in ready futures count towards it, so
+  // a caller waiting on a later future while keeping earlier graphs alive
+  // would wait forever.
+  std::vector<std::future<Graph>> generate_async(
+      const GenStartedCallback& gen_started_callback);
 
-    void start();
-    void stop();
+  // Complete once generate() returns or every future is ready.
+  Stats get_stats();
 
-    ~Worker();
+ private:
+  using JobCallback = std::function<void(int index)>;
 
-   private:
-    enum class State { Idle, Working, ShouldTerminate };
+  void add_jobs(const JobCallback& job);
 
-    std::thread thread_;
-    GetJobCallback get_job_callback_;
-    std::atomic<State> state_ = State::Idle;
-  };
+  std::unique_lock<std::mutex> lock_callbacks();
 
-  std::list<Worker> workers_;
-  std::list<JobCallback> jobs_;
   int threads_count_;
   int graphs_count_;
-  std::mutex job_mutex_;
-  GraphGenerator graph_generator_;
+  int max_graphs_in_flight_;
+  int lanes_count_;
+  std::mutex callback_mutex_;
+  GraphGenerator::Params graph_generator_params_;
+  GraphGenerator::Stats graphs_stats_;
+  std::atomic<std::int64_t> callback_wait_nanoseconds_ = 0;
+  std::atomic<std::uint64_t> callback_waits_count_ = 0;
+  // Set once generate() fails, lanes stop taking new graphs.
+  std::atomic<bool> is_stopped_ = false;
+  std::vector<std::atomic<int>> lane_jobs_counts_;
+  ThreadPool::Stats initial_thread_pool_stats_;
+  std::shared_ptr<GraphArenaPool> graph_arena_pool_;
+  std::shared_ptr<GraphArenaPool> branch_arena_pool_ =
+      std::make_shared<GraphArenaPool>();
+  TaskGroup jobs_;
 };
 }  // namespace uni_course_cpp
@@ -1,8 +1,9 @@
 #include "graph_generator.hpp"
 #include <algorithm>
-#include <atomic>
-#include <list>
-#include <random>
+#include <chrono>
+#include <optional>
+#include "thread_pool.hpp"
+#include "tracer.hpp"
 
 namespace {
 
@@ -13,211 +14,376 @@ static constexpr uni_course_cpp::Graph::Depth kDepthDifferenceYellow = 1;
 static constexpr uni_course_cpp::Graph::Depth kYellowDepthGap = 1;
 static constexpr uni_course_cpp::Graph::Depth kYellowInitialDepth = 1;
 static constexpr uni_course_cpp::Graph::Depth kRedInitialDepth = 1;
-const int kMaxThreadsCount = std::thread::hardware_concurrency();
-
-bool random_boolean(double probability) {
-  std::random_device rd{};
-  std::mt19937 rng{rd()};
-  std::bernoulli_distribution d(probability);
-  return d(rng);
-}
-
-int random_int(int limit) {
-  std::random_device rd;
-  std::mt19937 rng(rd());
-  std::uniform_int_distribution<int> uni(0, limit);
-  return uni(rng);
-}
-
-int get_random_vertex_id(
-    const std::vector<uni_course_cpp::Graph::VertexId>& vertex_ids) {
-  return vertex_ids.at(random_int(vertex_ids.size() - 1));
-}
-
-std::vector<uni_course_cpp::Graph::VertexId> get_unconnected_vertex_ids(
-    std::mutex& edge_generator_mutex,
-    const uni_course_cpp::Graph& graph,
-    uni_course_cpp::Graph::VertexId vertex_id) {
-  std::vector<uni_course_cpp::Graph::VertexId> suitable_vertices;
-  for (const auto candidate_id :
-       graph.vertex_ids_at_depth(graph.get_vertex_depth(vertex_id) + 1)) {
-    const auto has_edge = [&graph, &edge_generator_mutex, vertex_id,
-                           candidate_id]() {
-      const std::lock_guard<std::mutex> lock(edge_generator_mutex);
-      return graph.has_edge(vertex_id, candidate_id);
-    }();
-    if (!has_edge) {
-      suitable_vertices.emplace_back(candidate_id);
-    }
+static constexpr int kUnconnectedVertexAttemptsCount = 8;
+static constexpr std::uint64_t kEdgeDecisionCounter = 0;
+static constexpr std::uint64_t kVertexChoiceCounter = 1;
+static constexpr std::size_t kColorChunkSize = 4096;
+
+using Phase = uni_course_cpp::GraphGenerator::Phase;
+using Clock = std::chrono::steady_clock;
+
+const char* get_chunk_trace_name(Phase phase) {
+  switch (phase) {
+    case Phase::Grey:
+      return "grey chunk";
+    case Phase::Green:
+      return "green chunk";
+    case Phase::Yellow:
+      return "yellow chunk";
+    case Phase::Red:
+      return "red chunk";
+  }
+  return "color chunk";
+}
+
+double get_rate(std::size_t count, std::chrono::nanoseconds duration) {
+  if (duration == std::chrono::nanoseconds::zero()) {
+    return 0;
   }
-  return suitable_vertices;
+  return count / std::chrono::duration<double>(duration).count();
+}
+
+uni_course_cpp::RandomStream get_random_stream(std::uint64_t seed,
+                                               Phase phase) {
+  return uni_course_cpp::RandomStream(seed, static_cast<std::uint64_t>(phase));
 }
 }  // namespace
 
 namespace uni_course_cpp {
 
+double GraphGenerator::Stats::get_vertices_per_second() const {
+  return get_rate(vertices_count, duration);
+}
+
+double GraphGenerator::Stats::get_edges_per_second() const {
+  return get_rate(edges_count, duration);
+}
+
+GraphGenerator::Stats& GraphGenerator::Stats::operator+=(const Stats& other) {
+  for (std::size_t i = 0; i < kPhasesCount; i++) {
+    phase_durations[i] += other.phase_durations[i];
+  }
+  duration += other.duration;
+  vertices_count += other.vertices_count;
+  edges_count += other.edges_count;
+  return *this;
+}
+
+GraphGenerator::NextDepthConnections::NextDepthConnections(
+    const Graph& graph)
+    : offsets_(graph.get_vertices().size() + 1) {
+  const auto is_next_depth_edge = [&graph](const Graph::Edge& edge) {
+    return graph.get_vertex_depth(edge.to_vertex_id) ==
+           graph.get_vertex_depth(edge.from_vertex_id) + 1;
+  };
+  for (const auto& edge : graph.get_edges()) {
+    if (is_next_depth_edge(edge)) {
+      offsets_[edge.from_vertex_id + 1]++;
+    }
+  }
+  for (std::size_t i = 1; i < offsets_.size(); i++) {
+    offsets_[i] += offsets_[i - 1];
+  }
+  vertex_ids_.resize(offsets_.back());
+  auto next_positions = std::vector<std::size_t>(offsets_.cbegin(),
+                                                 offsets_.cend() - 1);
+  for (const auto& edge : graph.get_edges()) {
+    if (is_next_depth_edge(edge)) {
+      vertex_ids_[next_positions[edge.from_vertex_id]++] = edge.to_vertex_id;
+    }
+  }
+}
+
+bool GraphGenerator::NextDepthConnections::are_connected(
+    Graph::VertexId vertex_id,
+    Graph::VertexId next_depth_vertex_id) const {
+  return std::find(vertex_ids_.cbegin() + offsets_[vertex_id],
+                   vertex_ids_.cbegin() + offsets_[vertex_id + 1],
+                   next_depth_vertex_id) !=
+         vertex_ids_.cbegin() + offsets_[vertex_id + 1];
+}
+
+std::optional<Graph::VertexId>
+GraphGenerator::NextDepthConnections::get_random_unconnected_vertex_id(
+    const Graph& graph,
+    const RandomStream& random_stream,
+    Graph::VertexId vertex_id) const {
+  const auto& candidate_ids =
+      graph.vertex_ids_at_depth(graph.get_vertex_depth(vertex_id) + 1);
+  if (candidate_ids.empty()) {
+    return std::nullopt;
+  }
+  auto counter = kVertexChoiceCounter;
+  for (int attempt = 0; attempt < kUnconnectedVertexAttemptsCount;
+       attempt++) {
+    const auto candidate_id = candidate_ids[random_stream.random_int(
+        candidate_ids.size() - 1, vertex_id, counter++)];
+    if (!are_connected(vertex_id, candidate_id)) {
+      return candidate_id;
+    }
+  }
+  auto unconnected_vertex_ids = std::vector<Graph::VertexId>();
+  for (const auto candidate_id : candidate_ids) {
+    if (!are_connected(vertex_id, candidate_id)) {
+      unconnected_vertex_ids.emplace_back(candidate_id);
+    }
+  }
+  if (unconnected_vertex_ids.empty()) {
+    return std::nullopt;
+  }
+  return unconnected_vertex_ids[random_stream.random_int(
+      unconnected_vertex_ids.size() - 1, vertex_id, counter)];
+}
+
 Graph GraphGenerator::generate() const {
-  auto graph = Graph();
-  if (params_.depth() == 0) {
-    return graph;
-  }
-  generate_grey_edges(graph);
-  std::mutex edge_generator_mutex;
-  std::thread green_thread([this, &graph, &edge_generator_mutex]() {
-    generate_green_edges(graph, edge_generator_mutex);
-  });
-  std::thread yellow_thread([this, &graph, &edge_generator_mutex]() {
-    generate_yellow_edges(graph, edge_generator_mutex);
-  });
-  std::thread red_thread([this, &graph, &edge_generator_mutex]() {
-    generate_red_edges(graph, edge_generator_mutex);
-  });
-  green_thread.join();
-  yellow_thread.join();
-  red_thread.join();
+  auto stats = Stats();
+  return generate(stats);
+}
+
+Graph GraphGenerator::create_graph(GraphArenaPool* arena_pool) {
+  if (arena_pool == nullptr) {
+    return Graph();
+  }
+  return Graph(arena_pool->acquire());
+}
+
+Graph GraphGenerator::generate(Stats& stats) const {
+  const auto start = Clock::now();
+  auto graph = create_graph(graph_arena_pool_.get());
+  if (params_.depth() > 0) {
+    generate_grey_edges(graph, stats);
+    graph.add_edges(generate_color_edges(
+        graph, {Phase::Green, Phase::Yellow, Phase::Red}, stats));
+  }
+  graph.freeze();
+  stats.duration += Clock::now() - start;
+  stats.vertices_count += graph.get_vertices().size();
+  stats.edges_count += graph.get_edges().size();
   return graph;
 }
 
-void GraphGenerator::generate_grey_branch(Graph& graph,
-                                          std::mutex& edge_generator_mutex,
+void GraphGenerator::generate_phase(Phase phase, Graph& graph) const {
+  auto stats = Stats();
+  if (phase == Phase::Grey) {
+    if (params_.depth() > 0) {
+      generate_grey_edges(graph, stats);
+    }
+    return;
+  }
+  graph.add_edges(generate_color_edges(graph, {phase}, stats));
+}
+
+GraphGenerator::ProposedEdges GraphGenerator::generate_color_edges(
+    const Graph& graph,
+    std::initializer_list<Phase> phases,
+    Stats& stats) const {
+  const auto trace_scope = TraceScope("color edges");
+  const auto has_phase = [&phases](Phase phase) {
+    return std::find(phases.begin(), phases.end(), phase) != phases.end();
+  };
+  auto chunks = std::vector<std::pair<Phase, VertexRange>>();
+  const auto add_chunks = [&chunks](Phase phase, Graph::Depth depth,
+                                    std::size_t vertices_count) {
+    for (std::size_t begin = 0; begin < vertices_count;
+         begin += kColorChunkSize) {
+      chunks.emplace_back(
+          phase,
+          VertexRange{depth, begin,
+                      std::min(begin + kColorChunkSize, vertices_count)});
+    }
+  };
+  if (has_phase(Phase::Green)) {
+    add_chunks(Phase::Green, kGraphDefaultDepth, graph.get_vertices().size());
+  }
+  if (params_.depth() >= 3 && has_phase(Phase::Yellow)) {
+    for (int depth = kYellowInitialDepth;
+         depth <= graph.get_depth() - kDepthDifferenceYellow; depth++) {
+      add_chunks(Phase::Yellow, depth,
+                 graph.vertex_ids_at_depth(depth).size());
+    }
+  }
+  if (params_.depth() >= 3 && has_phase(Phase::Red)) {
+    for (int depth = kRedInitialDepth;
+         depth <= graph.get_depth() - kDepthDifferenceRed; depth++) {
+      add_chunks(Phase::Red, depth, graph.vertex_ids_at_depth(depth).size());
+    }
+  }
+
+  const NextDepthConnections connections(graph);
+  auto chunks_edges = std::vector<ProposedEdges>(chunks.size());
+  // Every chunk times itself into its own slot, summed once all are done.
+  auto chunk_durations = std::vector<Stats::Duration>(chunks.size());
+  TaskGroup chunk_tasks;
+  for (std::size_t i = 0; i < chunks.size(); i++) {
+    chunk_tasks.run([this, &graph, &connections, &chunk = chunks[i],
+                     &chunk_edges = chunks_edges[i],
+                     &chunk_duration = chunk_durations[i], i]() {
+      const auto start = Clock::now();
+      const auto& [phase, range] = chunk;
+      const auto trace_scope = TraceScope(get_chunk_trace_name(phase), i);
+      switch (phase) {
+        case Phase::Green:
+          generate_green_edges(graph, range, chunk_edges);
+          break;
+        case Phase::Yellow:
+          generate_yellow_edges(graph, connections, range, chunk_edges);
+          break;
+        case Phase::Red:
+          generate_red_edges(graph, range, chunk_edges);
+          break;
+        case Phase::Grey:
+          break;
+      }
+      chunk_duration = Clock::now() - start;
+    });
+  }
+  chunk_tasks.wait();
+  for (std::size_t i = 0; i < chunks.size(); i++) {
+    stats.phase_durations[static_cast<std::size_t>(chunks[i].first)] +=
+        chunk_durations[i];
+  }
+
+  std::size_t edges_count = 0;
+  for (const auto& edges : chunks_edges) {
+    edges_count += edges.size();
+  }
+  auto color_edges = ProposedEdges();
+  color_edges.reserve(edges_count);
+  for (const auto& edges : chunks_edges) {
+    color_edges.insert(color_edges.end(), edges.cbegin(), edges.cend());
+  }
+  return color_edges;
+}
+
+void GraphGenerator::generate_grey_branch(RandomEngine& engine,
+                                          Graph& subgraph,
                                           Graph::VertexId vertex_id,
                                           Graph::Depth current_depth) const {
   const double probability = (params_.depth() - current_depth) /
                              ((double)params_.depth() - kGraphDefaultDepth);
-  if (!random_boolean(probability))
+  if (!engine.random_boolean(probability))
     return;
-  const auto new_vertex_id = [&graph, &edge_generator_mutex, vertex_id]() {
-    const std::lock_guard lock(edge_generator_mutex);
-    const auto new_vertex_id = graph.add_vertex();
-    graph.add_edge(vertex_id, new_vertex_id);
-    return new_vertex_id;
-  }();
+  const auto new_vertex_id = subgraph.add_vertex();
+  subgraph.add_edge(vertex_id, new_vertex_id);
 
   for (int i = 0; i < params_.new_vertices_count(); i++) {
-    generate_grey_branch(graph, edge_generator_mutex, new_vertex_id,
-                         current_depth + 1);
+    generate_grey_branch(engine, subgraph, new_vertex_id, current_depth + 1);
   }
 }
 
-void GraphGenerator::generate_grey_edges(Graph& graph) const {
+void GraphGenerator::generate_grey_edges(Graph& graph, Stats& stats) const {
+  const auto trace_scope = TraceScope("grey edges");
+  auto& grey_duration =
+      stats.phase_durations[static_cast<std::size_t>(Phase::Grey)];
+  const auto start = Clock::now();
   const Graph::VertexId first_vertex_id = graph.add_vertex();
-  if (params_.depth() == 1)
+  if (params_.depth() == 1) {
+    grey_duration += Clock::now() - start;
     return;
-  using JobCallback = std::function<void()>;
-  auto jobs = std::list<JobCallback>();
-  std::mutex edge_generator_mutex;
-  std::atomic<bool> should_terminate = false;
-  std::atomic<int> jobs_counter = params_.new_vertices_count();
+  }
+  auto subgraphs = std::vector<Graph>();
+  subgraphs.reserve(params_.new_vertices_count());
   for (int i = 0; i < params_.new_vertices_count(); i++) {
-    jobs.push_back([&graph, &edge_generator_mutex, first_vertex_id,
-                    &jobs_counter, this]() {
-      generate_grey_branch(graph, edge_generator_mutex, first_vertex_id,
+    subgraphs.push_back(create_graph(branch_arena_pool_.get()));
+  }
+  auto branch_durations =
+      std::vector<Stats::Duration>(params_.new_vertices_count());
+  const auto random_stream =
+      get_random_stream(params_.seed(), Phase::Grey);
+  TaskGroup branch_tasks;
+  for (int i = 0; i < params_.new_vertices_count(); i++) {
+    branch_tasks.run([&subgraph = subgraphs[i],
+                      &branch_duration = branch_durations[i],
+                      branch_seed = random_stream.get(i), i, this]() {
+      const auto trace_scope = TraceScope("grey branch", i);
+      const auto branch_start = Clock::now();
+      auto engine = RandomEngine(branch_seed);
+      const auto root_vertex_id = subgraph.add_vertex();
+      generate_grey_branch(engine, subgraph, root_vertex_id,
                            kGraphDefaultDepth);
-      jobs_counter--;
+      branch_duration = Clock::now() - branch_start;
     });
   }
-  std::mutex job_mutex;
+  const auto wait_start = Clock::now();
+  branch_tasks.wait();
+  // The branches this thread ran while waiting are timed by themselves.
+  const auto wait_end = Clock::now();
 
-  const auto worker = [&should_terminate, &job_mutex, &jobs]() {
-    while (true) {
-      if (should_terminate) {
-        return;
-      }
-      const auto job_optional = [&job_mutex,
-                                 &jobs]() -> std::optional<JobCallback> {
-        const std::lock_guard lock(job_mutex);
-        if (!jobs.empty()) {
-          auto job = jobs.front();
-          jobs.pop_front();
-          return job;
-        }
-        return std::nullopt;
-      }();
-      if (job_optional.has_value()) {
-        const auto& job = job_optional.value();
-        job();
-      }
-    }
-  };
-
-  const auto threads_count =
-      std::min(kMaxThreadsCount, params_.new_vertices_count());
-  auto threads = std::vector<std::thread>();
-  threads.reserve(threads_count);
-
-  for (int i = 0; i < threads_count; ++i) {
-    threads.emplace_back(worker);
+  for (const auto& subgraph : subgraphs) {
+    graph.splice_subgraph(subgraph, first_vertex_id);
   }
-
-  while (jobs_counter != 0) {
-  }
-
-  should_terminate = true;
-  for (auto& thread : threads) {
-    thread.join();
+  grey_duration += (wait_start - start) + (Clock::now() - wait_end);
+  for (const auto& branch_duration : branch_durations) {
+    grey_duration += branch_duration;
   }
 }
 
-void GraphGenerator::generate_green_edges(
-    Graph& graph,
-    std::mutex& edge_generator_mutex) const {
+void GraphGenerator::generate_green_edges(const Graph& graph,
+                                          const VertexRange& range,
+                                          ProposedEdges& green_edges) const {
+  const auto random_stream =
+      get_random_stream(params_.seed(), Phase::Green);
   const auto& vertices = graph.get_vertices();
-  std::for_each(vertices.cbegin(), vertices.cend(),
-                [&graph, &edge_generator_mutex](const auto& vertex) {
-                  if (random_boolean(kGreenEdgeProbability)) {
-                    const std::lock_guard lock(edge_generator_mutex);
-                    graph.add_edge(vertex.id, vertex.id);
-                  }
-                });
+  for (auto i = range.begin; i < range.end; i++) {
+    if (random_stream.random_boolean(kGreenEdgeProbability, vertices[i].id)) {
+      green_edges.emplace_back(vertices[i].id, vertices[i].id);
+    }
+  }
 }
 
 void GraphGenerator::generate_yellow_edges(
-    Graph& graph,
-    std::mutex& edge_generator_mutex) const {
-  if (params_.depth() < 3)
-    return;
+    const Graph& graph,
+    const NextDepthConnections& connections,
+    const VertexRange& range,
+    ProposedEdges& yellow_edges) const {
+  const auto random_stream =
+      get_random_stream(params_.seed(), Phase::Yellow);
   const double probability_per_step =
       1.0 /
       ((double)graph.get_depth() - (kGraphDefaultDepth + kYellowDepthGap));
-  for (int depth = kYellowInitialDepth;
-       depth <= graph.get_depth() - kDepthDifferenceYellow; depth++) {
-    const auto& vertices_at_current_depth = graph.vertex_ids_at_depth(depth);
-    std::for_each(
-        vertices_at_current_depth.cbegin(), vertices_at_current_depth.cend(),
-        [&graph, &edge_generator_mutex, depth,
-         probability_per_step](auto vertex_id) {
-          if (random_boolean(depth * probability_per_step)) {
-            const auto unconnected_vertex_ids = get_unconnected_vertex_ids(
-                edge_generator_mutex, graph, vertex_id);
-            if (!unconnected_vertex_ids.empty()) {
-              const std::lock_guard lock(edge_generator_mutex);
-              graph.add_edge(vertex_id,
-                             get_random_vertex_id(unconnected_vertex_ids));
-            }
-          }
-        });
-  }
-}
-
-void GraphGenerator::generate_red_edges(
-    Graph& graph,
-    std::mutex& edge_generator_mutex) const {
-  if (params_.depth() < 3)
-    return;
-  for (int depth = kRedInitialDepth;
-       depth <= graph.get_depth() - kDepthDifferenceRed; depth++) {
-    const auto& vertices_at_current_depth = graph.vertex_ids_at_depth(depth);
-    std::for_each(
-        vertices_at_current_depth.cbegin(), vertices_at_current_depth.cend(),
-        [&graph, &edge_generator_mutex, depth](auto vertex_id) {
-          if (random_boolean(kRedEdgeProbability)) {
-            const auto& possible_vertices =
-                graph.vertex_ids_at_depth(depth + kDepthDifferenceRed);
-
-            const std::lock_guard lock(edge_generator_mutex);
-            graph.add_edge(vertex_id, get_random_vertex_id(possible_vertices));
-          }
-        });
+  const auto* const vertex_ids =
+      graph.vertex_ids_at_depth(range.depth).data() + range.begin;
+  const auto vertices_count = range.end - range.begin;
+  auto should_add_edges = std::vector<std::uint8_t>();
+  random_stream.random_booleans(range.depth * probability_per_step,
+                                vertex_ids, vertices_count,
+                                kEdgeDecisionCounter, should_add_edges);
+  for (std::size_t i = 0; i < vertices_count; i++) {
+    if (!should_add_edges[i]) {
+      continue;
+    }
+    const auto unconnected_vertex_id =
+        connections.get_random_unconnected_vertex_id(graph, random_stream,
+                                                     vertex_ids[i]);
+    if (unconnected_vertex_id.has_value()) {
+      yellow_edges.emplace_back(vertex_ids[i], unconnected_vertex_id.value());
+    }
+  }
+}
+
+void GraphGenerator::generate_red_edges(const Graph& graph,
+                                        const VertexRange& range,
+                                        ProposedEdges& red_edges) const {
+  const auto random_stream =
+      get_random_stream(params_.seed(), Phase::Red);
+  const auto* const vertex_ids =
+      graph.vertex_ids_at_depth(range.depth).data() + range.begin;
+  const auto vertices_count = range.end - range.begin;
+  const auto& possible_vertices =
+      graph.vertex_ids_at_depth(range.depth + kDepthDifferenceRed);
+  auto should_add_edges = std::vector<std::uint8_t>();
+  auto possible_vertex_indexes = std::vector<int>();
+  random_stream.random_booleans(kRedEdgeProbability, vertex_ids,
+                                vertices_count, kEdgeDecisionCounter,
+                                should_add_edges);
+  random_stream.random_ints(possible_vertices.size() - 1, vertex_ids,
+                            vertices_count, kVertexChoiceCounter,
+                            possible_vertex_indexes);
+  for (std::size_t i = 0; i < vertices_count; i++) {
+    if (should_add_edges[i]) {
+      red_edges.emplace_back(vertex_ids[i],
+                             possible_vertices[possible_vertex_indexes[i]]);
+    }
   }
 }
 }  // namespace uni_course_cpp
@@ -1,44 +1,140 @@
 #pragma once
 
-#include <mutex>
-#include <thread>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 #include "graph.hpp"
+#include "graph_arena_pool.hpp"
+#include "random_engine.hpp"
 
 namespace uni_course_cpp {
 class GraphGenerator {
  public:
   struct Params {
    public:
-    explicit Params(Graph::Depth depth, int new_vertices_count)
-        : depth_(depth), new_vertices_count_(new_vertices_count) {}
+    explicit Params(
+        Graph::Depth depth,
+        int new_vertices_count,
+        std::uint64_t seed = RandomEngine::get_thread_engine()())
+        : depth_(depth), new_vertices_count_(new_vertices_count), seed_(seed) {}
 
     Graph::Depth depth() const { return depth_; }
     int new_vertices_count() const { return new_vertices_count_; }
+    std::uint64_t seed() const { return seed_; }
 
    private:
     Graph::Depth depth_ = 0;
     int new_vertices_count_ = 0;
+    std::uint64_t seed_ = 0;
   };
 
-  explicit GraphGenerator(const Params&& params) : params_(params) {}
+  // Generation steps in the order generate() runs them. Color phases only
+  // read the grey edges, so they can run in any order.
+  enum class Phase : std::uint64_t { Grey, Green, Yellow, Red };
+  static constexpr std::size_t kPhasesCount = 4;
+
+  // Phase durations are summed over every thread that worked on the phase, so
+  // they can add up to more than `duration`, the wall time of generate().
+  struct Stats {
+    using Duration = std::chrono::nanoseconds;
+
+    std::array<Duration, kPhasesCount> phase_durations = {};
+    Duration duration = Duration::zero();
+    std::size_t vertices_count = 0;
+    std::size_t edges_count = 0;
+
+    Duration get_phase_duration(Phase phase) const {
+      return phase_durations[static_cast<std::size_t>(phase)];
+    }
+    double get_vertices_per_second() const;
+    double get_edges_per_second() const;
+
+    Stats& operator+=(const Stats& other);
+  };
+
+  // With arena pools, the graph is built in an arena of `graph_arena_pool`
+  // and its grey branches in ones of `branch_arena_pool`, otherwise on the
+  // global heap. Branches get their own pool so that a limit on the graph
+  // pool can't leave a generator waiting for an arena it already holds.
+  explicit GraphGenerator(
+      const Params&& params,
+      std::shared_ptr<GraphArenaPool> graph_arena_pool = nullptr,
+      std::shared_ptr<GraphArenaPool> branch_arena_pool = nullptr)
+      : params_(params),
+        graph_arena_pool_(std::move(graph_arena_pool)),
+        branch_arena_pool_(std::move(branch_arena_pool)) {}
 
   Graph generate() const;
 
+  Graph generate(Stats& stats) const;
+
+  // Runs one phase on `graph`, for benchmarks and profiling. The grey phase
+  // expects an empty graph, color phases a graph with only grey edges. The
+  // graph isn't frozen.
+  void generate_phase(Phase phase, Graph& graph) const;
+
  private:
+  using ProposedEdges =
+      std::vector<std::pair<Graph::VertexId, Graph::VertexId>>;
+
+  struct VertexRange {
+    Graph::Depth depth = 0;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  // Next-depth vertices every vertex is already connected to, precomputed
+  // once into a flat array so that the yellow pass doesn't query the graph.
+  class NextDepthConnections {
+   public:
+    explicit NextDepthConnections(const Graph& graph);
+
+    bool are_connected(Graph::VertexId vertex_id,
+                       Graph::VertexId next_depth_vertex_id) const;
+
+    std::optional<Graph::VertexId> get_random_unconnected_vertex_id(
+        const Graph& graph,
+        const RandomStream& random_stream,
+        Graph::VertexId vertex_id) const;
+
+   private:
+    std::vector<std::size_t> offsets_;
+    std::vector<Graph::VertexId> vertex_ids_;
+  };
+
   Params params_;
+  std::shared_ptr<GraphArenaPool> graph_arena_pool_;
+  std::shared_ptr<GraphArenaPool> branch_arena_pool_;
+
+  static Graph create_graph(GraphArenaPool* arena_pool);
+
+  void generate_grey_edges(Graph& graph, Stats& stats) const;
 
-  void generate_grey_edges(Graph& graph) const;
+  ProposedEdges generate_color_edges(const Graph& graph,
+                                     std::initializer_list<Phase> phases,
+                                     Stats& stats) const;
 
-  void generate_green_edges(Graph& graph,
-                            std::mutex& edge_generator_mutex) const;
+  void generate_green_edges(const Graph& graph,
+                            const VertexRange& range,
+                            ProposedEdges& green_edges) const;
 
-  void generate_yellow_edges(Graph& graph,
-                             std::mutex& edge_generator_mutex) const;
+  void generate_yellow_edges(const Graph& graph,
+                             const NextDepthConnections& connections,
+                             const VertexRange& range,
+                             ProposedEdges& yellow_edges) const;
 
-  void generate_red_edges(Graph& graph, std::mutex& edge_generator_mutex) const;
+  void generate_red_edges(const Graph& graph,
+                          const VertexRange& range,
+                          ProposedEdges& red_edges) const;
 
-  void generate_grey_branch(Graph& graph,
-                            std::mutex& edge_generator_mutex,
+  void generate_grey_branch(RandomEngine& engine,
+                            Graph& subgraph,
                             Graph::VertexId vertex_id,
                             Graph::Depth current_depth) const;
 };
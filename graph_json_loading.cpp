@@ -0,0 +1,405 @@
+#include "graph_json_loading.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "graph_printing.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+using uni_course_cpp::Graph;
+using uni_course_cpp::kGraphDefaultDepth;
+
+static constexpr std::size_t kMinChunkSize = 1 << 20;
+static constexpr int kChunksPerThread = 4;
+static constexpr std::string_view kIdKey = "id";
+static constexpr std::string_view kEdgeIdsKey = "edge_ids";
+static constexpr std::string_view kVertexIdsKey = "vertex_ids";
+static constexpr std::string_view kDepthKey = "depth";
+static constexpr std::string_view kColorKey = "color";
+static constexpr std::string_view kVerticesKey = "vertices";
+static constexpr std::string_view kEdgesKey = "edges";
+static constexpr Graph::Edge::Color kEdgeColors[] = {
+    Graph::Edge::Color::Gray, Graph::Edge::Color::Green,
+    Graph::Edge::Color::Yellow, Graph::Edge::Color::Red};
+
+enum class JsonSection { Vertices, Edges };
+
+struct ParsedEdge {
+  Graph::VertexId from_vertex_id = 0;
+  Graph::VertexId to_vertex_id = 0;
+  Graph::Edge::Color color = Graph::Edge::Color::Gray;
+};
+
+// Objects parsed by one chunk. Ids are checked to be consecutive inside the
+// chunk, the first ones are checked against the previous chunks on merge.
+struct ParsedChunk {
+  bool is_empty = true;
+  JsonSection first_section = JsonSection::Vertices;
+  bool closes_vertices = false;
+  bool closes_graph = false;
+  Graph::VertexId first_vertex_id = 0;
+  Graph::EdgeId first_edge_id = 0;
+  std::vector<Graph::Depth> vertex_depths;
+  std::vector<std::size_t> adjacency_sizes;
+  std::vector<Graph::EdgeId> adjacency_edge_ids;
+  std::vector<ParsedEdge> edges;
+};
+
+class JsonCursor {
+ public:
+  JsonCursor(std::string_view json, std::size_t position)
+      : json_(json), position_(position) {}
+
+  std::size_t position() const { return position_; }
+
+  void skip_whitespace() {
+    while (position_ < json_.size() && is_whitespace(json_[position_])) {
+      position_++;
+    }
+  }
+
+  bool is_at_end() {
+    skip_whitespace();
+    return position_ == json_.size();
+  }
+
+  char peek() {
+    skip_whitespace();
+    if (position_ == json_.size()) {
+      fail("a value");
+    }
+    return json_[position_];
+  }
+
+  bool try_consume(char character) {
+    if (peek() != character) {
+      return false;
+    }
+    position_++;
+    return true;
+  }
+
+  void expect(char character) {
+    if (!try_consume(character)) {
+      fail(std::string_view(&character, 1));
+    }
+  }
+
+  std::string_view parse_string() {
+    expect('"');
+    const auto end = json_.find('"', position_);
+    if (end == std::string_view::npos) {
+      fail("\"");
+    }
+    const auto string = json_.substr(position_, end - position_);
+    position_ = end + 1;
+    return string;
+  }
+
+  std::string_view parse_key() {
+    const auto key = parse_string();
+    expect(':');
+    return key;
+  }
+
+  void expect_key(std::string_view key) {
+    if (parse_key() != key) {
+      fail(key);
+    }
+  }
+
+  int parse_int() {
+    skip_whitespace();
+    int value = 0;
+    const auto [end, error] = std::from_chars(
+        json_.data() + position_, json_.data() + json_.size(), value);
+    if (error != std::errc() || value < 0) {
+      fail("a non-negative integer");
+    }
+    position_ = end - json_.data();
+    return value;
+  }
+
+  Graph::Edge::Color parse_color() {
+    const auto name = parse_string();
+    for (const auto color : kEdgeColors) {
+      if (name == uni_course_cpp::printing::print_edge_color(color)) {
+        return color;
+      }
+    }
+    fail("an edge color");
+  }
+
+  [[noreturn]] void fail(std::string_view expected) const {
+    throw std::runtime_error("Invalid graph JSON at byte " +
+                             std::to_string(position_) + ": expected " +
+                             std::string(expected));
+  }
+
+ private:
+  static bool is_whitespace(char character) {
+    return character == ' ' || character == '\t' || character == '\n' ||
+           character == '\r';
+  }
+
+  std::string_view json_;
+  std::size_t position_ = 0;
+};
+
+// Parses `"edge_ids":[...], "depth": D}` or `"vertex_ids": [F,T],
+// "color": "C"}`, the part of an object after its id.
+JsonSection parse_object_body(JsonCursor& cursor, ParsedChunk& chunk) {
+  const auto key = cursor.parse_key();
+  if (key == kEdgeIdsKey) {
+    cursor.expect('[');
+    std::size_t adjacency_size = 0;
+    if (!cursor.try_consume(']')) {
+      do {
+        chunk.adjacency_edge_ids.push_back(cursor.parse_int());
+        adjacency_size++;
+      } while (cursor.try_consume(','));
+      cursor.expect(']');
+    }
+    cursor.expect(',');
+    cursor.expect_key(kDepthKey);
+    chunk.vertex_depths.push_back(cursor.parse_int());
+    chunk.adjacency_sizes.push_back(adjacency_size);
+    cursor.expect('}');
+    return JsonSection::Vertices;
+  }
+  if (key == kVertexIdsKey) {
+    auto edge = ParsedEdge();
+    cursor.expect('[');
+    edge.from_vertex_id = cursor.parse_int();
+    cursor.expect(',');
+    edge.to_vertex_id = cursor.parse_int();
+    cursor.expect(']');
+    cursor.expect(',');
+    cursor.expect_key(kColorKey);
+    edge.color = cursor.parse_color();
+    cursor.expect('}');
+    chunk.edges.push_back(edge);
+    return JsonSection::Edges;
+  }
+  cursor.fail("\"edge_ids\" or \"vertex_ids\"");
+}
+
+// Parses every object that starts in [begin, end) together with the
+// separators after it. Every '{' past the document's first one opens a vertex
+// or an edge, so a chunk boundary is moved to the next '{'. The chunk at the
+// start of the vertices array begins in the vertices section, any other one
+// learns its section from its first object.
+ParsedChunk parse_chunk(std::string_view json,
+                        std::size_t begin,
+                        std::size_t end,
+                        bool is_first) {
+  auto chunk = ParsedChunk();
+  auto cursor = JsonCursor(json, is_first ? begin : json.find('{', begin));
+  if (!is_first && (cursor.position() == std::string_view::npos ||
+                    cursor.position() >= end)) {
+    return chunk;
+  }
+  chunk.is_empty = false;
+  bool is_object_expected = false;
+  auto section = JsonSection::Vertices;
+  bool is_section_known = is_first;
+  while (true) {
+    if (!is_object_expected && cursor.peek() == ']') {
+      // Closes the array of the current section.
+      cursor.expect(']');
+      if (section == JsonSection::Vertices) {
+        cursor.expect(',');
+        cursor.expect_key(kEdgesKey);
+        cursor.expect('[');
+        chunk.closes_vertices = true;
+        section = JsonSection::Edges;
+        continue;
+      }
+      cursor.expect('}');
+      if (!cursor.is_at_end()) {
+        cursor.fail("the end of the document");
+      }
+      chunk.closes_graph = true;
+      break;
+    }
+    if (cursor.peek() == '{' && cursor.position() >= end) {
+      break;
+    }
+    cursor.expect('{');
+    cursor.expect_key(kIdKey);
+    const auto id = cursor.parse_int();
+    cursor.expect(',');
+    const auto object_section = parse_object_body(cursor, chunk);
+    if (!is_section_known) {
+      section = object_section;
+      chunk.first_section = object_section;
+      is_section_known = true;
+    }
+    if (object_section != section) {
+      cursor.fail(section == JsonSection::Vertices ? "a vertex" : "an edge");
+    }
+    if (section == JsonSection::Vertices) {
+      if (chunk.vertex_depths.size() == 1) {
+        chunk.first_vertex_id = id;
+      } else if (id != chunk.first_vertex_id +
+                           static_cast<int>(chunk.vertex_depths.size()) - 1) {
+        cursor.fail("consecutive vertex ids");
+      }
+    } else {
+      if (chunk.edges.size() == 1) {
+        chunk.first_edge_id = id;
+      } else if (id != chunk.first_edge_id +
+                           static_cast<int>(chunk.edges.size()) - 1) {
+        cursor.fail("consecutive edge ids");
+      }
+    }
+    is_object_expected = cursor.try_consume(',');
+  }
+  return chunk;
+}
+
+std::vector<ParsedChunk> parse_chunks(std::string_view json,
+                                      std::size_t begin) {
+  const auto& thread_pool = uni_course_cpp::ThreadPool::get_thread_pool();
+  const auto size = json.size() - begin;
+  const auto chunks_count = std::max<std::size_t>(
+      1, std::min<std::size_t>(size / kMinChunkSize,
+                               kChunksPerThread * thread_pool.threads_count()));
+  const auto chunk_size = size / chunks_count;
+  auto chunks = std::vector<ParsedChunk>(chunks_count);
+  uni_course_cpp::TaskGroup chunk_tasks;
+  for (std::size_t i = 0; i < chunks_count; i++) {
+    const auto chunk_begin = begin + i * chunk_size;
+    const auto chunk_end =
+        i + 1 == chunks_count ? json.size() : chunk_begin + chunk_size;
+    chunk_tasks.run([json, chunk_begin, chunk_end, i, &chunk = chunks[i]]() {
+      chunk = parse_chunk(json, chunk_begin, chunk_end, i == 0);
+    });
+  }
+  chunk_tasks.wait();
+  return chunks;
+}
+
+void validate_chunks(const std::vector<ParsedChunk>& chunks) {
+  bool are_vertices_closed = false;
+  bool is_graph_closed = false;
+  Graph::VertexId vertices_count = 0;
+  Graph::EdgeId edges_count = 0;
+  for (const auto& chunk : chunks) {
+    if (chunk.is_empty) {
+      continue;
+    }
+    if (is_graph_closed ||
+        are_vertices_closed != (chunk.first_section == JsonSection::Edges)) {
+      throw std::runtime_error("Invalid graph JSON: misplaced object");
+    }
+    if ((!chunk.vertex_depths.empty() &&
+         chunk.first_vertex_id != vertices_count) ||
+        (!chunk.edges.empty() && chunk.first_edge_id != edges_count)) {
+      throw std::runtime_error("Invalid graph JSON: ids don't match positions");
+    }
+    vertices_count += chunk.vertex_depths.size();
+    edges_count += chunk.edges.size();
+    are_vertices_closed = are_vertices_closed || chunk.closes_vertices;
+    is_graph_closed = chunk.closes_graph;
+  }
+  if (!is_graph_closed) {
+    throw std::runtime_error("Invalid graph JSON: unexpected end of document");
+  }
+}
+
+// Concatenates the chunks into frozen graph storage. Vertex arrays are copied
+// in parallel at their final offsets, edges are appended in order.
+Graph::FrozenParts merge_chunks(std::vector<ParsedChunk>& chunks,
+                                Graph::Depth depth) {
+  auto vertex_offsets = std::vector<std::size_t>(chunks.size() + 1);
+  auto adjacency_offsets = std::vector<std::size_t>(chunks.size() + 1);
+  std::size_t edges_count = 0;
+  for (std::size_t i = 0; i < chunks.size(); i++) {
+    vertex_offsets[i + 1] = vertex_offsets[i] + chunks[i].vertex_depths.size();
+    adjacency_offsets[i + 1] =
+        adjacency_offsets[i] + chunks[i].adjacency_edge_ids.size();
+    edges_count += chunks[i].edges.size();
+  }
+  const auto vertices_count = vertex_offsets.back();
+
+  auto parts = Graph::FrozenParts();
+  parts.vertex_depths.resize(vertices_count);
+  parts.adjacency_offsets.resize(vertices_count + 1);
+  parts.adjacency_edge_ids.resize(adjacency_offsets.back());
+  uni_course_cpp::TaskGroup copy_tasks;
+  for (std::size_t i = 0; i < chunks.size(); i++) {
+    copy_tasks.run([&, i]() {
+      const auto& chunk = chunks[i];
+      std::copy(chunk.vertex_depths.begin(), chunk.vertex_depths.end(),
+                parts.vertex_depths.begin() + vertex_offsets[i]);
+      std::copy(chunk.adjacency_edge_ids.begin(),
+                chunk.adjacency_edge_ids.end(),
+                parts.adjacency_edge_ids.begin() + adjacency_offsets[i]);
+      auto adjacency_offset = adjacency_offsets[i];
+      for (std::size_t j = 0; j < chunk.adjacency_sizes.size(); j++) {
+        adjacency_offset += chunk.adjacency_sizes[j];
+        parts.adjacency_offsets[vertex_offsets[i] + j + 1] = adjacency_offset;
+      }
+    });
+  }
+  parts.edges.reserve(edges_count);
+  for (auto& chunk : chunks) {
+    for (const auto& edge : chunk.edges) {
+      if (static_cast<std::size_t>(edge.from_vertex_id) >= vertices_count ||
+          static_cast<std::size_t>(edge.to_vertex_id) >= vertices_count) {
+        throw std::runtime_error("Invalid graph JSON: unknown edge vertex");
+      }
+      parts.edges.emplace_back(parts.edges.size(), edge.from_vertex_id,
+                               edge.to_vertex_id, edge.color);
+    }
+    chunk.edges = std::vector<ParsedEdge>();
+  }
+  copy_tasks.wait();
+
+  for (const auto edge_id : parts.adjacency_edge_ids) {
+    if (static_cast<std::size_t>(edge_id) >= edges_count) {
+      throw std::runtime_error("Invalid graph JSON: unknown vertex edge");
+    }
+  }
+  parts.depth_list.resize(depth);
+  for (std::size_t vertex_id = 0; vertex_id < vertices_count; vertex_id++) {
+    const auto vertex_depth = parts.vertex_depths[vertex_id];
+    if (vertex_depth < kGraphDefaultDepth || vertex_depth > depth) {
+      throw std::runtime_error("Invalid graph JSON: vertex depth is out of "
+                               "the graph depth");
+    }
+    parts.depth_list[vertex_depth - kGraphDefaultDepth].push_back(vertex_id);
+  }
+  return parts;
+}
+}  // namespace
+
+namespace uni_course_cpp {
+namespace loading {
+namespace json {
+
+Graph parse_graph(std::string_view json) {
+  auto cursor = JsonCursor(json, 0);
+  cursor.expect('{');
+  cursor.expect_key(kDepthKey);
+  const auto depth = cursor.parse_int();
+  cursor.expect(',');
+  cursor.expect_key(kVerticesKey);
+  cursor.expect('[');
+
+  auto chunks = parse_chunks(json, cursor.position());
+  validate_chunks(chunks);
+  return Graph(merge_chunks(chunks, depth));
+}
+
+Graph read_graph_from_file(const std::string& filename) {
+  const auto file = MappedFile(filename);
+  return parse_graph(file.view());
+}
+}  // namespace json
+}  // namespace loading
+}  // namespace uni_course_cpp
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "graph.hpp"
+
+namespace uni_course_cpp {
+namespace loading {
+namespace json {
+
+// Parses the document written by printing::json::write_graph back into a
+// frozen graph. Only that schema is accepted: keys in the same order,
+// vertex and edge ids equal to their positions. Edge colors are taken from
+// the document. Large documents are split at object boundaries and parsed in
+// parallel on the ThreadPool.
+Graph parse_graph(std::string_view json);
+
+// Memory-maps the file and parses it with parse_graph.
+Graph read_graph_from_file(const std::string& filename);
+}  // namespace json
+}  // namespace loading
+}  // namespace uni_course_cpp
@@ -1,64 +1,257 @@
 #include "graph_json_printing.hpp"
-#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "graph_printing.hpp"
+#include "thread_pool.hpp"
+#include "tracer.hpp"
+
+namespace {
+static constexpr std::size_t kPrintCapacity = 256;
+static constexpr std::size_t kChunkCapacity = 1 << 16;
+static constexpr std::size_t kItemsPerChunk = 1 << 15;
+static constexpr int kChunksPerThreadInWave = 2;
+static constexpr int kFilePermissions = 0644;
+static constexpr std::string_view kGraphDepthKey = "{\"depth\": ";
+static constexpr std::string_view kGraphVerticesKey = ", \"vertices\": [";
+static constexpr std::string_view kGraphEdgesKey = "],\t\"edges\": [";
+static constexpr std::string_view kGraphEnd = "]}\n";
+
+enum class JsonSection { Vertices, Edges };
+
+struct JsonChunk {
+  JsonSection section;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+};
+
+// Chunks of one wave are claimed one by one by the writing thread and the
+// pool tasks helping it. Shared, so that a task starting after the wave is
+// over finds nothing left to claim.
+struct JsonWave {
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  std::atomic<std::size_t> next_chunk = 0;
+  std::atomic<std::size_t> written_chunks_count = 0;
+  std::mutex exception_mutex;
+  std::exception_ptr exception;
+};
+
+void write_to_file(
+    const std::string& filename,
+    const std::function<void(uni_course_cpp::printing::OutputBuffer&)>&
+        write) {
+  const auto trace_scope = uni_course_cpp::TraceScope("write json file");
+  const int file_descriptor =
+      ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, kFilePermissions);
+  if (file_descriptor < 0) {
+    throw std::runtime_error("Failed to open " + filename + ": " +
+                             std::strerror(errno));
+  }
+  try {
+    uni_course_cpp::printing::OutputBuffer output(file_descriptor);
+    write(output);
+    output.flush();
+  } catch (...) {
+    ::close(file_descriptor);
+    throw;
+  }
+  ::close(file_descriptor);
+}
+
+std::vector<JsonChunk> get_json_chunks(const uni_course_cpp::Graph& graph) {
+  auto chunks = std::vector<JsonChunk>();
+  const auto add_chunks = [&chunks](JsonSection section,
+                                    std::size_t items_count) {
+    for (std::size_t begin = 0; begin < items_count; begin += kItemsPerChunk) {
+      chunks.push_back(
+          {section, begin, std::min(begin + kItemsPerChunk, items_count)});
+    }
+  };
+  add_chunks(JsonSection::Vertices, graph.get_vertices().size());
+  add_chunks(JsonSection::Edges, graph.get_edges().size());
+  return chunks;
+}
+}  // namespace
 
 namespace uni_course_cpp {
 namespace printing {
 namespace json {
 
-std::string print_vertex(const Graph::Vertex& vertex, const Graph& graph) {
-  const auto& connected_edge_ids =
-      graph.edge_ids_connected_to_vertex(vertex.id);
-  std::stringstream string_to_print;
-  string_to_print << "{\"id\":" << vertex.id << ",\"edge_ids\":[";
-  for (const auto id : connected_edge_ids) {
-    string_to_print << id;
-    string_to_print << ",";
-  }
-  if (connected_edge_ids.size() != 0) {
-    string_to_print.seekp(-1, string_to_print.cur);
+void write_vertex(const Graph::Vertex& vertex,
+                  const Graph& graph,
+                  OutputBuffer& output) {
+  output.write("{\"id\":");
+  output.write(vertex.id);
+  output.write(",\"edge_ids\":[");
+  bool is_first = true;
+  for (const auto id : graph.edge_ids_connected_to_vertex(vertex.id)) {
+    if (!is_first) {
+      output.write(',');
+    }
+    output.write(id);
+    is_first = false;
   }
-  string_to_print << "], ";
-  string_to_print << "\"depth\": " << graph.get_vertex_depth(vertex.id);
-  string_to_print << '}';
-  return string_to_print.str();
+  output.write("], \"depth\": ");
+  output.write(graph.get_vertex_depth(vertex.id));
+  output.write('}');
 }
 
-std::string print_edge(const Graph::Edge& edge) {
-  std::stringstream string_to_print;
-  string_to_print << "{\"id\": " << edge.id << ",\"vertex_ids\": ["
-                  << edge.from_vertex_id << "," << edge.to_vertex_id << "], "
-                  << "\"color\": \"" << print_edge_color(edge.color) << "\""
-                  << "}";
-  return string_to_print.str();
+void write_edge(const Graph::Edge& edge, OutputBuffer& output) {
+  output.write("{\"id\": ");
+  output.write(edge.id);
+  output.write(",\"vertex_ids\": [");
+  output.write(edge.from_vertex_id);
+  output.write(',');
+  output.write(edge.to_vertex_id);
+  output.write("], \"color\": \"");
+  output.write(print_edge_color(edge.color));
+  output.write("\"}");
 }
 
-std::string print_graph(const Graph& graph) {
-  std::stringstream string_to_print;
-  string_to_print << "{"
-                  << "\"depth\": " << graph.get_depth() << ", \"vertices\": [";
+void write_graph(const Graph& graph, OutputBuffer& output) {
+  output.write(kGraphDepthKey);
+  output.write(graph.get_depth());
+  output.write(kGraphVerticesKey);
+  bool is_first = true;
   for (const auto& vertex : graph.get_vertices()) {
-    string_to_print << json::print_vertex(vertex, graph);
-    string_to_print << ",";
-  }
-  if (graph.get_vertices().size() != 0) {
-    string_to_print.seekp(-1, string_to_print.cur);
+    if (!is_first) {
+      output.write(',');
+    }
+    write_vertex(vertex, graph, output);
+    is_first = false;
   }
-  string_to_print << ']';
-  string_to_print << ","
-                  << "\t\"edges\": [";
-  for (const auto& [edge_id, edge] : graph.get_edges_ids_to_edges()) {
-    string_to_print << json::print_edge(edge);
-    string_to_print << ",";
+  output.write(kGraphEdgesKey);
+  is_first = true;
+  for (const auto& edge : graph.get_edges()) {
+    if (!is_first) {
+      output.write(',');
+    }
+    write_edge(edge, output);
+    is_first = false;
   }
-  if (graph.get_edges_ids_to_edges().size() != 0) {
-    string_to_print.seekp(-1, string_to_print.cur);
-  }
-  string_to_print << ']';
-  string_to_print << "}"
-                  << "\n";
-  return string_to_print.str();
+  output.write(kGraphEnd);
+}
+
+void write_graph_to_file_parallel(const Graph& graph,
+                                  const std::string& filename) {
+  const auto chunks = get_json_chunks(graph);
+  auto& thread_pool = ThreadPool::get_thread_pool();
+  const std::size_t wave_size =
+      kChunksPerThreadInWave * thread_pool.threads_count();
+  auto chunk_strings = std::vector<std::string>(wave_size);
+  const auto write_chunk = [&graph](const JsonChunk& chunk,
+                                    std::string& chunk_string) {
+    const auto trace_scope = TraceScope("serialize json chunk", chunk.begin);
+    chunk_string.clear();
+    OutputBuffer output(chunk_string, kChunkCapacity);
+    for (auto i = chunk.begin; i < chunk.end; i++) {
+      if (i != chunk.begin) {
+        output.write(',');
+      }
+      if (chunk.section == JsonSection::Vertices) {
+        write_vertex(graph.get_vertices()[i], graph, output);
+      } else {
+        write_edge(graph.get_edges()[i], output);
+      }
+    }
+    output.flush();
+  };
+
+  write_to_file(filename, [&](OutputBuffer& output) {
+    output.write(kGraphDepthKey);
+    output.write(graph.get_depth());
+    output.write(kGraphVerticesKey);
+    bool are_edges_started = false;
+    for (std::size_t wave_begin = 0; wave_begin < chunks.size();
+         wave_begin += wave_size) {
+      const auto wave_end = std::min(wave_begin + wave_size, chunks.size());
+      const auto wave = std::make_shared<JsonWave>();
+      wave->begin = wave_begin;
+      wave->end = wave_end;
+      wave->next_chunk = wave_begin;
+      const auto write_wave = [&write_chunk, &chunks, &chunk_strings,
+                               &thread_pool, wave]() {
+        const auto chunks_count = wave->end - wave->begin;
+        for (auto i = wave->next_chunk++; i < wave->end;
+             i = wave->next_chunk++) {
+          try {
+            write_chunk(chunks[i], chunk_strings[i - wave->begin]);
+          } catch (...) {
+            const std::lock_guard lock(wave->exception_mutex);
+            if (!wave->exception) {
+              wave->exception = std::current_exception();
+            }
+          }
+          if (++wave->written_chunks_count == chunks_count) {
+            thread_pool.notify_waiters();
+          }
+        }
+      };
+      // The calling thread writes chunks too, so the wave is done even if
+      // every pool thread is busy, e.g. with generation jobs waiting on the
+      // pipeline this write is part of.
+      for (auto i = wave_begin + 1; i < wave_end; i++) {
+        thread_pool.submit(write_wave);
+      }
+      write_wave();
+      thread_pool.wait_until([&wave]() {
+        return wave->written_chunks_count == wave->end - wave->begin;
+      });
+      if (wave->exception) {
+        std::rethrow_exception(wave->exception);
+      }
+
+      for (auto i = wave_begin; i < wave_end; i++) {
+        if (chunks[i].section == JsonSection::Edges && !are_edges_started) {
+          output.write(kGraphEdgesKey);
+          are_edges_started = true;
+        } else if (chunks[i].begin != 0) {
+          output.write(',');
+        }
+        output.write(chunk_strings[i - wave_begin]);
+      }
+    }
+    if (!are_edges_started) {
+      output.write(kGraphEdgesKey);
+    }
+    output.write(kGraphEnd);
+  });
+}
+
+std::string print_vertex(const Graph::Vertex& vertex, const Graph& graph) {
+  std::string string_to_print;
+  OutputBuffer output(string_to_print, kPrintCapacity);
+  write_vertex(vertex, graph, output);
+  output.flush();
+  return string_to_print;
+}
+
+std::string print_edge(const Graph::Edge& edge) {
+  std::string string_to_print;
+  OutputBuffer output(string_to_print, kPrintCapacity);
+  write_edge(edge, output);
+  output.flush();
+  return string_to_print;
+}
+
+std::string print_graph(const Graph& graph) {
+  std::string string_to_print;
+  OutputBuffer output(string_to_print);
+  write_graph(graph, output);
+  output.flush();
+  return string_to_print;
 }
 }  // namespace json
 }  // namespace printing
@@ -2,6 +2,7 @@
 
 #include <string>
 #include "graph.hpp"
+#include "output_buffer.hpp"
 
 namespace uni_course_cpp {
 namespace printing {
@@ -12,6 +13,21 @@ std::string print_vertex(const Graph::Vertex& vertex, const Graph& graph);
 std::string print_edge(const Graph::Edge& edge);
 
 std::string print_graph(const Graph& graph);
+
+void write_vertex(const Graph::Vertex& vertex,
+                  const Graph& graph,
+                  OutputBuffer& output);
+
+void write_edge(const Graph::Edge& edge, OutputBuffer& output);
+
+void write_graph(const Graph& graph, OutputBuffer& output);
+
+// Streams the graph straight into the file without building the document in
+// memory first. Vertices and edges are split into chunks that are serialized
+// in parallel on the ThreadPool and written in waves, so only a few of them
+// are held in memory at a time.
+void write_graph_to_file_parallel(const Graph& graph,
+                                  const std::string& filename);
 }  // namespace json
 }  // namespace printing
 }  // namespace uni_course_cpp
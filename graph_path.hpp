@@ -0,0 +1,23 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+
+namespace uni_course_cpp {
+struct GraphPath {
+  using Duration = int;
+
+  GraphPath(std::vector<Graph::VertexId> init_vertex_ids,
+            std::vector<Graph::EdgeId> init_edge_ids,
+            Duration init_duration)
+      : vertex_ids(std::move(init_vertex_ids)),
+        edge_ids(std::move(init_edge_ids)),
+        duration(init_duration) {}
+
+  int length() const { return edge_ids.size(); }
+
+  std::vector<Graph::VertexId> vertex_ids;
+  std::vector<Graph::EdgeId> edge_ids;
+  Duration duration = 0;
+};
+}  // namespace uni_course_cpp
@@ -1,6 +1,8 @@
 #include "graph_printing.hpp"
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 
 namespace {
 static constexpr int kDefaultDepth = 1;
@@ -22,12 +24,12 @@ std::string print_vertices(const uni_course_cpp::Graph& graph) {
 
 std::string print_edges(const uni_course_cpp::Graph& graph) {
   std::stringstream string_to_print;
-  const auto& edges = graph.get_edges_ids_to_edges();
+  const auto& edges = graph.get_edges();
   string_to_print << "{amount: " << edges.size() << ", distribution: {";
 
   std::unordered_map<uni_course_cpp::Graph::Edge::Color, int>
       amount_of_edges_by_color;
-  for (const auto& [edge_id, edge] : edges) {
+  for (const auto& edge : edges) {
     amount_of_edges_by_color[edge.color]++;
   }
   for (auto it = amount_of_edges_by_color.cbegin();
@@ -47,7 +49,7 @@ std::string print_edges(const uni_course_cpp::Graph& graph) {
 namespace uni_course_cpp {
 namespace printing {
 
-std::string print_edge_color(uni_course_cpp::Graph::Edge::Color color) {
+std::string_view print_edge_color(uni_course_cpp::Graph::Edge::Color color) {
   switch (color) {
     case uni_course_cpp::Graph::Edge::Color::Gray:
       return "gray";
@@ -58,6 +60,7 @@ std::string print_edge_color(uni_course_cpp::Graph::Edge::Color color) {
     case uni_course_cpp::Graph::Edge::Color::Red:
       return "red";
   }
+  throw std::runtime_error("Unknown edge color");
 }
 
 std::string print_graph(const Graph& graph) {
@@ -1,12 +1,13 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include "graph.hpp"
 
 namespace uni_course_cpp {
 namespace printing {
 
-std::string print_edge_color(Graph::Edge::Color color);
+std::string_view print_edge_color(Graph::Edge::Color color);
 
 std::string print_graph(const Graph& graph);
 
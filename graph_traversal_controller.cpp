@@ -0,0 +1,119 @@
+#include "graph_traversal_controller.hpp"
+#include <algorithm>
+#include <utility>
+#include "tracer.hpp"
+
+namespace {
+
+static constexpr std::uint64_t kPrincessStream = 0;
+}  // namespace
+
+namespace uni_course_cpp {
+
+GraphTraversalController::GraphTraversalController(
+    int threads_count,
+    const TraversalStartedCallback& traversal_started_callback,
+    const TraversalFinishedCallback& traversal_finished_callback,
+    std::uint64_t seed,
+    const GraphTraverser::EdgeDurations& edge_durations)
+    : threads_count_(std::min(std::max(threads_count, 1),
+                              ThreadPool::get_thread_pool().threads_count())),
+      traversal_started_callback_(traversal_started_callback),
+      traversal_finished_callback_(traversal_finished_callback),
+      seed_(seed),
+      edge_durations_(edge_durations) {}
+
+void GraphTraversalController::add_graph(int index, Graph&& graph) {
+  {
+    const std::lock_guard lock(jobs_mutex_);
+    pending_jobs_.push_back({index, std::move(graph)});
+    if (active_lanes_count_ == threads_count_) {
+      return;
+    }
+    active_lanes_count_++;
+  }
+  lanes_.run([this]() { run_lane(); });
+}
+
+void GraphTraversalController::wait() {
+  lanes_.wait();
+  const std::lock_guard lock(jobs_mutex_);
+  if (exception_) {
+    std::rethrow_exception(std::exchange(exception_, nullptr));
+  }
+}
+
+void GraphTraversalController::traverse(std::vector<Graph>&& graphs) {
+  for (std::size_t i = 0; i < graphs.size(); i++) {
+    add_graph(i, std::move(graphs[i]));
+  }
+  wait();
+}
+
+void GraphTraversalController::run_lane() {
+  auto traverser = GraphTraverser(edge_durations_);
+  while (true) {
+    auto job = std::optional<Job>();
+    {
+      const std::lock_guard lock(jobs_mutex_);
+      if (pending_jobs_.empty()) {
+        active_lanes_count_--;
+        return;
+      }
+      job.emplace(std::move(pending_jobs_.front()));
+      pending_jobs_.pop_front();
+    }
+    try {
+      traverse_graph(traverser, *job);
+    } catch (...) {
+      const std::lock_guard lock(jobs_mutex_);
+      if (!exception_) {
+        exception_ = std::current_exception();
+      }
+    }
+  }
+}
+
+void GraphTraversalController::traverse_on_current_thread(int index,
+                                                          Graph&& graph) {
+  // Scratch buffers are kept per thread, as long as the durations match.
+  thread_local auto traverser = std::optional<GraphTraverser>();
+  thread_local auto traverser_edge_durations = GraphTraverser::EdgeDurations();
+  if (!traverser.has_value() || traverser_edge_durations != edge_durations_) {
+    traverser.emplace(edge_durations_);
+    traverser_edge_durations = edge_durations_;
+  }
+  auto job = Job{index, std::move(graph)};
+  traverse_graph(traverser.value(), job);
+}
+
+std::optional<GraphPath> GraphTraversalController::find_princess_path(
+    GraphTraverser& traverser,
+    const Graph& graph,
+    int index,
+    std::uint64_t seed) {
+  if (graph.get_depth() == 0) {
+    return std::nullopt;
+  }
+  const auto trace_scope = TraceScope("traverse graph", index);
+  const auto& princess_vertex_ids =
+      graph.vertex_ids_at_depth(graph.get_depth());
+  const auto princess_index =
+      RandomStream(seed, kPrincessStream)
+          .random_int(princess_vertex_ids.size() - 1, index);
+  return traverser.find_princess_path(graph,
+                                      princess_vertex_ids[princess_index]);
+}
+
+void GraphTraversalController::traverse_graph(GraphTraverser& traverser,
+                                              Job& job) {
+  {
+    const std::lock_guard lock(callback_mutex_);
+    traversal_started_callback_(job.index, job.graph);
+  }
+  auto princess_path =
+      find_princess_path(traverser, job.graph, job.index, seed_);
+  traversal_finished_callback_(job.index, std::move(job.graph),
+                               std::move(princess_path));
+}
+}  // namespace uni_course_cpp
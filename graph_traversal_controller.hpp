@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "graph.hpp"
+#include "graph_path.hpp"
+#include "graph_traverser.hpp"
+#include "random_engine.hpp"
+#include "thread_pool.hpp"
+
+namespace uni_course_cpp {
+class GraphTraversalController {
+ public:
+  using TraversalStartedCallback =
+      std::function<void(int index, const Graph& graph)>;
+  using TraversalFinishedCallback =
+      std::function<void(int index,
+                         Graph&& graph,
+                         std::optional<GraphPath>&& princess_path)>;
+
+  // At most `threads_count` graphs are traversed at the same time on the
+  // process-wide ThreadPool. The princess of every graph is a deepest vertex
+  // picked by `seed` and the graph index. Started callbacks are serialized,
+  // the finished callback is called without a lock so that it may block,
+  // e.g. on a full queue, without stalling the other lanes, and has to be
+  // thread-safe.
+  GraphTraversalController(
+      int threads_count,
+      const TraversalStartedCallback& traversal_started_callback,
+      const TraversalFinishedCallback& traversal_finished_callback,
+      std::uint64_t seed = RandomEngine::get_thread_engine()(),
+      const GraphTraverser::EdgeDurations& edge_durations =
+          GraphTraverser::kDefaultEdgeDurations);
+
+  // Queues a graph and returns right away. Safe to call from any thread,
+  // including a GenFinishedCallback, so that a graph is traversed as soon as
+  // it is generated.
+  void add_graph(int index, Graph&& graph);
+
+  // Waits until every queued graph is traversed and rethrows the first
+  // exception thrown by a traversal or a callback.
+  void wait();
+
+  // Traverses the whole batch, graph indexes are their positions.
+  void traverse(std::vector<Graph>&& graphs);
+
+  // Traverses one graph on the calling thread, callbacks included, for
+  // callers that bring their own threads: pool lanes can be starved by other
+  // pool jobs waiting on the very graphs they would traverse. Safe to call
+  // from several threads at once, exceptions are thrown to the caller.
+  void traverse_on_current_thread(int index, Graph&& graph);
+
+  // What every lane does to one graph, for callers that run the traversal on
+  // their own threads. Returns nothing for an empty graph.
+  static std::optional<GraphPath> find_princess_path(
+      GraphTraverser& traverser,
+      const Graph& graph,
+      int index,
+      std::uint64_t seed);
+
+ private:
+  struct Job {
+    int index = 0;
+    Graph graph;
+  };
+
+  void run_lane();
+
+  void traverse_graph(GraphTraverser& traverser, Job& job);
+
+  int threads_count_;
+  TraversalStartedCallback traversal_started_callback_;
+  TraversalFinishedCallback traversal_finished_callback_;
+  std::uint64_t seed_;
+  GraphTraverser::EdgeDurations edge_durations_;
+  std::mutex callback_mutex_;
+  std::mutex jobs_mutex_;
+  std::deque<Job> pending_jobs_;
+  int active_lanes_count_ = 0;
+  std::exception_ptr exception_;
+  TaskGroup lanes_;
+};
+}  // namespace uni_course_cpp
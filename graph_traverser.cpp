@@ -0,0 +1,99 @@
+#include "graph_traverser.hpp"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+static constexpr uni_course_cpp::GraphPath::Duration kInfiniteDuration =
+    std::numeric_limits<uni_course_cpp::GraphPath::Duration>::max();
+}  // namespace
+
+namespace uni_course_cpp {
+
+GraphTraverser::GraphTraverser(const EdgeDurations& edge_durations)
+    : edge_durations_(edge_durations) {
+  assert(std::all_of(edge_durations_.begin(), edge_durations_.end(),
+                     [](auto duration) { return duration >= 0; }) &&
+         "Edge duration is negative");
+  const auto max_duration =
+      *std::max_element(edge_durations_.begin(), edge_durations_.end());
+  buckets_.resize(max_duration + 1);
+}
+
+std::optional<GraphPath> GraphTraverser::find_shortest_path(
+    const Graph& graph,
+    Graph::VertexId source_vertex_id,
+    Graph::VertexId destination_vertex_id) {
+  assert(graph.has_vertex(source_vertex_id) && "Source vertex doesn't exist");
+  assert(graph.has_vertex(destination_vertex_id) &&
+         "Destination vertex doesn't exist");
+  const auto& edges = graph.get_edges();
+  durations_.assign(graph.get_vertices().size(), kInfiniteDuration);
+  previous_edge_ids_.assign(graph.get_vertices().size(), kNoEdge);
+  for (auto& bucket : buckets_) {
+    bucket.clear();
+  }
+
+  durations_[source_vertex_id] = 0;
+  buckets_[0].push_back(source_vertex_id);
+  std::size_t queued_count = 1;
+  for (GraphPath::Duration current = 0; queued_count > 0; current++) {
+    auto& bucket = buckets_[current % buckets_.size()];
+    // Zero-duration edges push into the bucket that is being drained, so it
+    // is emptied from the back until nothing is left.
+    while (!bucket.empty()) {
+      const auto vertex_id = bucket.back();
+      bucket.pop_back();
+      queued_count--;
+      if (durations_[vertex_id] != current) {
+        continue;
+      }
+      if (vertex_id == destination_vertex_id) {
+        return get_path(graph, source_vertex_id, destination_vertex_id);
+      }
+      for (const auto edge_id : graph.edge_ids_connected_to_vertex(vertex_id)) {
+        const auto& edge = edges[edge_id];
+        const auto next_vertex_id =
+            edge.from_vertex_id == vertex_id ? edge.to_vertex_id
+                                             : edge.from_vertex_id;
+        const auto duration = current + get_edge_duration(edge);
+        if (duration < durations_[next_vertex_id]) {
+          durations_[next_vertex_id] = duration;
+          previous_edge_ids_[next_vertex_id] = edge_id;
+          buckets_[duration % buckets_.size()].push_back(next_vertex_id);
+          queued_count++;
+        }
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<GraphPath> GraphTraverser::find_princess_path(
+    const Graph& graph,
+    Graph::VertexId princess_vertex_id) {
+  assert(graph.get_vertex_depth(princess_vertex_id) == graph.get_depth() &&
+         "Princess isn't at the deepest level");
+  return find_shortest_path(graph, 0, princess_vertex_id);
+}
+
+GraphPath GraphTraverser::get_path(
+    const Graph& graph,
+    Graph::VertexId source_vertex_id,
+    Graph::VertexId destination_vertex_id) const {
+  auto vertex_ids = std::vector<Graph::VertexId>{destination_vertex_id};
+  auto edge_ids = std::vector<Graph::EdgeId>();
+  for (auto vertex_id = destination_vertex_id; vertex_id != source_vertex_id;) {
+    const auto& edge = graph.get_edges()[previous_edge_ids_[vertex_id]];
+    edge_ids.push_back(edge.id);
+    vertex_id = edge.from_vertex_id == vertex_id ? edge.to_vertex_id
+                                                 : edge.from_vertex_id;
+    vertex_ids.push_back(vertex_id);
+  }
+  std::reverse(vertex_ids.begin(), vertex_ids.end());
+  std::reverse(edge_ids.begin(), edge_ids.end());
+  return GraphPath(std::move(vertex_ids), std::move(edge_ids),
+                   durations_[destination_vertex_id]);
+}
+
+}  // namespace uni_course_cpp
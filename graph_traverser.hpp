@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <vector>
+#include "graph.hpp"
+#include "graph_path.hpp"
+
+namespace uni_course_cpp {
+class GraphTraverser {
+ public:
+  // Time it takes to move along an edge, indexed by Graph::Edge::Color.
+  using EdgeDurations = std::array<GraphPath::Duration, 4>;
+
+  static constexpr EdgeDurations kDefaultEdgeDurations = {1, 2, 3, 2};
+
+  explicit GraphTraverser(const EdgeDurations& edge_durations =
+                              kDefaultEdgeDurations);
+
+  // Fastest route between two vertices, or nullopt if they aren't connected.
+  // Durations are small integers, so the frontier is a circular array of
+  // buckets, one per possible distance modulo the longest edge duration.
+  // Scratch buffers are kept between calls, a traverser must not be shared
+  // between threads.
+  std::optional<GraphPath> find_shortest_path(
+      const Graph& graph,
+      Graph::VertexId source_vertex_id,
+      Graph::VertexId destination_vertex_id);
+
+  // Fastest route of the knight from vertex 0 to the princess, who is at one
+  // of the deepest vertices.
+  std::optional<GraphPath> find_princess_path(
+      const Graph& graph,
+      Graph::VertexId princess_vertex_id);
+
+ private:
+  static constexpr Graph::EdgeId kNoEdge = -1;
+
+  GraphPath::Duration get_edge_duration(const Graph::Edge& edge) const {
+    return edge_durations_[static_cast<int>(edge.color)];
+  }
+
+  GraphPath get_path(const Graph& graph,
+                     Graph::VertexId source_vertex_id,
+                     Graph::VertexId destination_vertex_id) const;
+
+  EdgeDurations edge_durations_;
+  std::vector<GraphPath::Duration> durations_;
+  std::vector<Graph::EdgeId> previous_edge_ids_;
+  std::vector<std::vector<Graph::VertexId>> buckets_;
+};
+}  // namespace uni_course_cpp
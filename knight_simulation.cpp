@@ -0,0 +1,232 @@
+#include "knight_simulation.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include "graph_bfs.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+static constexpr std::uint64_t kMoveStream = 0;
+static constexpr std::uint64_t kMovesCounters = 2;
+static constexpr std::uint64_t kExplorationCounter = 0;
+static constexpr std::uint64_t kEdgeChoiceCounter = 1;
+
+// Min-heap of events packed into 64-bit keys: time in the high half, knight
+// id in the low one. Four children per node keep a level's keys in one cache
+// line and halve the tree height compared to a binary heap.
+class EventQueue {
+ public:
+  static constexpr std::size_t kArity = 4;
+
+  void reserve(std::size_t size) { keys_.reserve(size); }
+
+  bool empty() const { return keys_.empty(); }
+
+  void push(std::uint32_t time, std::uint32_t knight_id) {
+    keys_.push_back(get_key(time, knight_id));
+    sift_up(keys_.size() - 1);
+  }
+
+  std::pair<std::uint32_t, std::uint32_t> pop() {
+    const auto key = keys_.front();
+    keys_.front() = keys_.back();
+    keys_.pop_back();
+    if (!keys_.empty()) {
+      sift_down(0);
+    }
+    return {key >> 32, key & 0xffffffff};
+  }
+
+ private:
+  static std::uint64_t get_key(std::uint32_t time, std::uint32_t knight_id) {
+    return (std::uint64_t(time) << 32) | knight_id;
+  }
+
+  void sift_up(std::size_t index) {
+    const auto key = keys_[index];
+    while (index > 0) {
+      const auto parent = (index - 1) / kArity;
+      if (keys_[parent] <= key) {
+        break;
+      }
+      keys_[index] = keys_[parent];
+      index = parent;
+    }
+    keys_[index] = key;
+  }
+
+  void sift_down(std::size_t index) {
+    const auto key = keys_[index];
+    const auto size = keys_.size();
+    while (true) {
+      const auto first_child = index * kArity + 1;
+      if (first_child >= size) {
+        break;
+      }
+      const auto last_child = std::min(first_child + kArity, size);
+      auto min_child = first_child;
+      for (auto child = first_child + 1; child < last_child; child++) {
+        if (keys_[child] < keys_[min_child]) {
+          min_child = child;
+        }
+      }
+      if (key <= keys_[min_child]) {
+        break;
+      }
+      keys_[index] = keys_[min_child];
+      index = min_child;
+    }
+    keys_[index] = key;
+  }
+
+  std::vector<std::uint64_t> keys_;
+};
+
+uni_course_cpp::Graph::VertexId get_other_vertex_id(
+    const uni_course_cpp::Graph::Edge& edge,
+    uni_course_cpp::Graph::VertexId vertex_id) {
+  return edge.from_vertex_id == vertex_id ? edge.to_vertex_id
+                                          : edge.from_vertex_id;
+}
+}  // namespace
+
+namespace uni_course_cpp {
+
+GraphPath::Duration KnightSimulation::Result::get_arrival_time_quantile(
+    double quantile) const {
+  assert(!arrival_times.empty() && "No knight has arrived");
+  const auto index = static_cast<std::size_t>(
+      std::ceil(quantile * arrival_times.size()));
+  return arrival_times[std::clamp<std::size_t>(index, 1,
+                                               arrival_times.size()) -
+                       1];
+}
+
+KnightSimulation::KnightSimulation(const Graph& graph, const Params& params)
+    : graph_(graph), params_(params) {
+  assert(graph.has_vertex(params_.princess_vertex_id) &&
+         "Princess vertex doesn't exist");
+  assert(params_.knights_count >= 0 && params_.batches_count > 0);
+  if (params_.move_policy == MovePolicy::Homing) {
+    princess_hop_distances_ =
+        GraphBfs(graph_).get_hop_distances(params_.princess_vertex_id);
+  }
+}
+
+KnightSimulation::Result KnightSimulation::run() const {
+  const auto batches_count =
+      std::max(1, std::min(params_.batches_count, params_.knights_count));
+  const auto batch_size =
+      (params_.knights_count + batches_count - 1) / batches_count;
+  auto batches = std::vector<Batch>();
+  for (int begin = 0; begin < params_.knights_count; begin += batch_size) {
+    batches.push_back(
+        {begin, std::min(begin + batch_size, params_.knights_count)});
+  }
+
+  auto batch_results = std::vector<Result>(batches.size());
+  if (batches.size() == 1) {
+    batch_results[0] = run_batch(batches[0]);
+  } else {
+    TaskGroup batch_tasks;
+    for (std::size_t i = 0; i < batches.size(); i++) {
+      batch_tasks.run(
+          [this, &batch = batches[i], &result = batch_results[i]]() {
+            result = run_batch(batch);
+          });
+    }
+    batch_tasks.wait();
+  }
+
+  auto result = Result();
+  result.knights_count = params_.knights_count;
+  for (auto& batch_result : batch_results) {
+    result.arrived_knights_count += batch_result.arrived_knights_count;
+    result.events_count += batch_result.events_count;
+    result.arrival_times.insert(result.arrival_times.end(),
+                                batch_result.arrival_times.begin(),
+                                batch_result.arrival_times.end());
+  }
+  std::sort(result.arrival_times.begin(), result.arrival_times.end());
+  if (!result.arrival_times.empty()) {
+    result.arrival_times_histogram.resize(result.arrival_times.back() + 1);
+    for (const auto arrival_time : result.arrival_times) {
+      result.arrival_times_histogram[arrival_time]++;
+    }
+  }
+  return result;
+}
+
+KnightSimulation::Result KnightSimulation::run_batch(
+    const Batch& batch) const {
+  const auto random_stream = RandomStream(params_.seed, kMoveStream);
+  const auto knights_count = batch.end - batch.begin;
+  auto knights = Knights();
+  knights.vertex_ids.assign(knights_count, 0);
+  knights.moves_counts.assign(knights_count, 0);
+  auto events = EventQueue();
+  events.reserve(knights_count);
+  for (int i = 0; i < knights_count; i++) {
+    events.push(0, i);
+  }
+
+  auto result = Result();
+  while (!events.empty()) {
+    const auto [time, index] = events.pop();
+    result.events_count++;
+    const auto vertex_id = knights.vertex_ids[index];
+    if (vertex_id == params_.princess_vertex_id) {
+      result.arrived_knights_count++;
+      result.arrival_times.push_back(time);
+      continue;
+    }
+    auto& moves_count = knights.moves_counts[index];
+    if (moves_count == params_.max_moves_count ||
+        graph_.edge_ids_connected_to_vertex(vertex_id).empty()) {
+      continue;
+    }
+    const auto& edge = graph_.get_edges()[choose_edge(
+        random_stream, batch.begin + index, moves_count, vertex_id)];
+    knights.vertex_ids[index] = get_other_vertex_id(edge, vertex_id);
+    moves_count++;
+    events.push(time + params_.edge_durations[static_cast<int>(edge.color)],
+                index);
+  }
+  return result;
+}
+
+Graph::EdgeId KnightSimulation::choose_edge(const RandomStream& random_stream,
+                                            int knight_id,
+                                            int move_index,
+                                            Graph::VertexId vertex_id) const {
+  const auto edge_ids = graph_.edge_ids_connected_to_vertex(vertex_id);
+  const auto counter = move_index * kMovesCounters;
+  const bool is_exploring =
+      params_.move_policy == MovePolicy::RandomWalk ||
+      random_stream.random_boolean(params_.exploration_probability, knight_id,
+                                   counter + kExplorationCounter);
+  if (!is_exploring) {
+    const auto distance = princess_hop_distances_[vertex_id];
+    const auto is_closer = [this, vertex_id, distance](Graph::EdgeId edge_id) {
+      const auto next_vertex_id =
+          get_other_vertex_id(graph_.get_edges()[edge_id], vertex_id);
+      return princess_hop_distances_[next_vertex_id] >= 0 &&
+             princess_hop_distances_[next_vertex_id] < distance;
+    };
+    const int closer_count =
+        std::count_if(edge_ids.begin(), edge_ids.end(), is_closer);
+    if (closer_count > 0) {
+      auto choice = random_stream.random_int(closer_count - 1, knight_id,
+                                             counter + kEdgeChoiceCounter);
+      for (const auto edge_id : edge_ids) {
+        if (is_closer(edge_id) && choice-- == 0) {
+          return edge_id;
+        }
+      }
+    }
+  }
+  return edge_ids[random_stream.random_int(edge_ids.size() - 1, knight_id,
+                                           counter + kEdgeChoiceCounter)];
+}
+}  // namespace uni_course_cpp
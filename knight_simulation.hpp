@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "graph.hpp"
+#include "graph_path.hpp"
+#include "graph_traverser.hpp"
+#include "random_engine.hpp"
+
+namespace uni_course_cpp {
+// Discrete-event simulation of knights that all start at vertex 0 at time 0
+// and walk the graph until they reach the princess or run out of moves.
+// Knights don't interact, so they are split into batches that are simulated
+// independently, each with its own event queue. Every random choice depends
+// only on the seed, the knight and the move, so the result doesn't depend on
+// the batches count.
+class KnightSimulation {
+ public:
+  enum class MovePolicy {
+    // Every incident edge is equally likely.
+    RandomWalk,
+    // Moves to a vertex closer to the princess, or with
+    // `exploration_probability` along a random incident edge.
+    Homing,
+  };
+
+  struct Params {
+    int knights_count = 1000;
+    Graph::VertexId princess_vertex_id = 0;
+    MovePolicy move_policy = MovePolicy::Homing;
+    double exploration_probability = 0.2;
+    int max_moves_count = 1000;
+    // Batches run in parallel on the ThreadPool, 1 runs on the calling thread.
+    int batches_count = 1;
+    std::uint64_t seed = RandomEngine::get_thread_engine()();
+    GraphTraverser::EdgeDurations edge_durations =
+        GraphTraverser::kDefaultEdgeDurations;
+  };
+
+  struct Result {
+    int knights_count = 0;
+    int arrived_knights_count = 0;
+    std::size_t events_count = 0;
+    // Arrival times of the knights that reached the princess, sorted.
+    std::vector<GraphPath::Duration> arrival_times;
+    // Number of knights that arrived at every moment from 0 to the latest
+    // arrival time.
+    std::vector<int> arrival_times_histogram;
+
+    // Arrival time of the given share of the arrived knights, `quantile` is
+    // in [0, 1]. There must be at least one arrival.
+    GraphPath::Duration get_arrival_time_quantile(double quantile) const;
+  };
+
+  KnightSimulation(const Graph& graph, const Params& params);
+
+  Result run() const;
+
+ private:
+  struct Batch {
+    int begin = 0;
+    int end = 0;
+  };
+
+  // State of the knights of one batch, one array per field.
+  struct Knights {
+    std::vector<Graph::VertexId> vertex_ids;
+    std::vector<int> moves_counts;
+  };
+
+  Result run_batch(const Batch& batch) const;
+
+  Graph::EdgeId choose_edge(const RandomStream& random_stream,
+                            int knight_id,
+                            int move_index,
+                            Graph::VertexId vertex_id) const;
+
+  const Graph& graph_;
+  Params params_;
+  std::vector<int> princess_hop_distances_;
+};
+}  // namespace uni_course_cpp
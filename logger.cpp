@@ -1,20 +1,47 @@
 #include "logger.hpp"
 #include <chrono>
-#include <ctime>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
+#include <string_view>
 #include "configs.hpp"
 
 namespace {
 
-std::string get_current_date_time() {
-  const auto date_time = std::chrono::system_clock::now();
-  const auto date_time_t = std::chrono::system_clock::to_time_t(date_time);
-  std::stringstream date_time_string;
-  date_time_string << std::put_time(std::localtime(&date_time_t),
-                                    "%Y.%m.%d %H:%M:%S");
-  return date_time_string.str();
+static constexpr auto kFlusherSleepDuration = std::chrono::milliseconds(5);
+static constexpr std::size_t kDateTimeCapacity = 32;
+
+// Timestamps only change once a second, so the formatted string is reused
+// until the second changes.
+class DateTimeFormatter {
+ public:
+  std::string_view format(std::time_t time) {
+    if (time != time_) {
+      std::tm local_date_time{};
+      localtime_r(&time, &local_date_time);
+      length_ = std::strftime(buffer_, sizeof(buffer_), "%Y.%m.%d %H:%M:%S",
+                              &local_date_time);
+      time_ = time;
+    }
+    return std::string_view(buffer_, length_);
+  }
+
+ private:
+  std::time_t time_ = -1;
+  char buffer_[kDateTimeCapacity] = {};
+  std::size_t length_ = 0;
+};
+
+std::time_t get_current_time() {
+  return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+}
+
+void append_line(std::string& lines,
+                 std::time_t time,
+                 const std::string& string) {
+  thread_local DateTimeFormatter date_time_formatter;
+  lines += date_time_formatter.format(time);
+  lines += ' ';
+  lines += string;
+  lines += '\n';
 }
 }  // namespace
 
@@ -26,14 +53,123 @@ Logger& Logger::get_logger() {
 }
 
 void Logger::log(const std::string& string) {
-  const std::string log_string = get_current_date_time() + " " + string;
+  log(std::string(string));
+}
+
+void Logger::log(std::string&& string) {
+  auto message = Message{get_current_time(), std::move(string)};
+  async_producers_count_++;
+  if (mode_ == Mode::Blocking) {
+    async_producers_count_--;
+    write_blocking(std::move(message));
+    return;
+  }
+  while (!messages_.try_push(message)) {
+    std::this_thread::yield();
+  }
+  queued_count_++;
+  async_producers_count_--;
+  if (is_flusher_sleeping_) {
+    const std::lock_guard lock(flusher_mutex_);
+    flusher_wakeup_.notify_one();
+  }
+}
 
+void Logger::set_mode(Mode mode) {
+  const std::lock_guard lock(mode_mutex_);
+  if (mode == mode_) {
+    return;
+  }
+  if (mode == Mode::Async) {
+    should_stop_flusher_ = false;
+    flusher_ = std::thread([this]() { run_flusher(); });
+    mode_ = Mode::Async;
+    return;
+  }
+  mode_ = Mode::Blocking;
+  // Producers that have already seen Async finish their push first, so the
+  // flusher's last drain picks them up.
+  while (async_producers_count_ > 0) {
+    std::this_thread::yield();
+  }
+  {
+    const std::lock_guard flusher_lock(flusher_mutex_);
+    should_stop_flusher_ = true;
+  }
+  flusher_wakeup_.notify_one();
+  flusher_.join();
+}
+
+void Logger::flush() {
+  const auto queued_count = queued_count_.load();
+  while (written_count_ < queued_count) {
+    {
+      const std::lock_guard lock(flusher_mutex_);
+      flusher_wakeup_.notify_one();
+    }
+    std::this_thread::yield();
+  }
+}
+
+void Logger::write_blocking(Message&& message) {
+  auto line = std::string();
+  append_line(line, message.time, message.string);
+  // Waits for a switch from Async to finish draining the queue, so a line is
+  // never written before lines logged earlier by the same thread.
+  const std::lock_guard mode_lock(mode_mutex_);
   const std::lock_guard lock(mutex_);
+  if (is_console_enabled_) {
+    std::cout << line << std::flush;
+  }
+  log_file_ << line << std::flush;
+}
 
-  std::cout << log_string << std::endl;
-  log_file_ << log_string << std::endl;
+void Logger::run_flusher() {
+  auto batch = std::string();
+  while (true) {
+    if (write_batch(batch) > 0) {
+      continue;
+    }
+    auto lock = std::unique_lock(flusher_mutex_);
+    if (should_stop_flusher_) {
+      lock.unlock();
+      // The last producers may have pushed after the queue looked empty.
+      while (write_batch(batch) > 0) {
+      }
+      return;
+    }
+    is_flusher_sleeping_ = true;
+    flusher_wakeup_.wait_for(lock, kFlusherSleepDuration);
+    is_flusher_sleeping_ = false;
+  }
 }
 
-Logger::Logger() : log_file_(config::kLogFilePath){};
+std::size_t Logger::write_batch(std::string& batch) {
+  std::size_t batch_size = 0;
+  while (auto message = messages_.try_pop()) {
+    append_line(batch, message->time, message->string);
+    batch_size++;
+  }
+  if (batch_size == 0) {
+    return 0;
+  }
+  {
+    const std::lock_guard lock(mutex_);
+    if (is_console_enabled_) {
+      std::cout << batch << std::flush;
+    }
+    log_file_ << batch << std::flush;
+  }
+  batch.clear();
+  written_count_ += batch_size;
+  return batch_size;
+}
+
+Logger::Logger()
+    : log_file_(config::kLogFilePath), messages_(kQueueCapacity) {}
+
+Logger::~Logger() {
+  set_mode(Mode::Blocking);
+}
 
 }  // namespace uni_course_cpp
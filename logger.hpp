@@ -1,23 +1,75 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
 #include <mutex>
 #include <string>
+#include <thread>
+#include "mpsc_ring_buffer.hpp"
 
 namespace uni_course_cpp {
 
 class Logger {
  public:
+  // Blocking writes every line before log() returns. Async hands lines to a
+  // lock-free queue drained by a background thread in batches; log() only
+  // waits if the queue is full.
+  enum class Mode { Blocking, Async };
+
   static Logger& get_logger();
   void log(const std::string& string);
+  void log(std::string&& string);
+
+  // Switching to Blocking writes everything queued so far and stops the
+  // background thread, use it before shutdown or when crashing.
+  void set_mode(Mode mode);
+
+  // Returns once every line logged before the call is written.
+  void flush();
+
+  // Lines always go to the log file, the console copy can be turned off.
+  void set_console_enabled(bool is_enabled) {
+    is_console_enabled_ = is_enabled;
+  }
 
  private:
+  struct Message {
+    std::time_t time = 0;
+    std::string string;
+  };
+
+  static constexpr std::size_t kQueueCapacity = 1 << 12;
+
   Logger();
+  ~Logger();
   Logger(const Logger&) = delete;
   Logger& operator=(const Logger&) = delete;
   Logger(Logger&&) = delete;
   Logger& operator=(Logger&&) = delete;
+
+  void write_blocking(Message&& message);
+  void run_flusher();
+  // Writes every queued line with one write per stream, returns the number
+  // of lines written.
+  std::size_t write_batch(std::string& batch);
+
   std::mutex mutex_;
   std::ofstream log_file_;
+  std::atomic<bool> is_console_enabled_ = true;
+
+  std::mutex mode_mutex_;
+  std::atomic<Mode> mode_ = Mode::Blocking;
+  std::atomic<int> async_producers_count_ = 0;
+  MpscRingBuffer<Message> messages_;
+  std::atomic<std::uint64_t> queued_count_ = 0;
+  std::atomic<std::uint64_t> written_count_ = 0;
+  std::atomic<bool> should_stop_flusher_ = false;
+  std::atomic<bool> is_flusher_sleeping_ = false;
+  std::mutex flusher_mutex_;
+  std::condition_variable flusher_wakeup_;
+  std::thread flusher_;
 };
 }  // namespace uni_course_cpp
@@ -1,27 +1,59 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <mutex>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "configs.hpp"
 #include "graph_generation_controller.hpp"
 #include "graph_generator.hpp"
 #include "graph_json_printing.hpp"
 #include "graph_printing.hpp"
+#include "graph_traversal_controller.hpp"
 #include "logger.hpp"
+#include "pipeline.hpp"
+#include "random_engine.hpp"
+#include "thread_pool.hpp"
+#include "tracer.hpp"
 
 static constexpr int kVerticesCount = 14;
 static constexpr int kInvalidDepth = -1;
 static constexpr int kInvalidNewVerticesCount = -1;
 static constexpr int kInvalidNewGraphsCount = -1;
 static constexpr int kInvalidThreadsCount = -1;
-
-void write_to_file(const std::string& string_to_write,
-                   const std::string& filename) {
-  std::ofstream output_file(filename);
-  output_file << string_to_write;
-  output_file.close();
-}
+static constexpr int kDefaultSweepGraphsCount = 10;
+static constexpr int kSweepColumnWidth = 12;
+static constexpr int kMillisecondsPrecision = 3;
+static constexpr std::array<std::string_view,
+                            uni_course_cpp::GraphGenerator::kPhasesCount>
+    kPhaseNames = {"grey", "green", "yellow", "red"};
+static constexpr std::size_t kStageQueueCapacity = 4;
+static constexpr int kSummarizeThreadsCount = 1;
+static constexpr int kGraphsInFlightPerThread = 2;
+static constexpr std::string_view kRangeSeparator = "..";
+static constexpr std::string_view kUsage =
+    "Usage: main [--trace]             interactive mode\n"
+    "       main [--config=<path>] [--depths=<list>]\n"
+    "            [--new-vertices-counts=<list>] [--threads=<list>]\n"
+    "            [--graphs-count=<n>] [--seed=<n>] [--verbose] [--trace]\n"
+    "A list is comma-separated numbers or inclusive ranges like 2..6.\n"
+    "--trace writes a Chrome trace-event timeline to temp/trace.json.\n"
+    "A config file holds the same options as key=value lines without \"--\",\n"
+    "lines starting with # are ignored. Command-line options win.\n"
+    "Flags take no value or one of true and false, e.g. verbose=false.\n";
 
 int handle_threads_count_input() {
   int threads = kInvalidThreadsCount;
@@ -103,55 +135,452 @@ void prepare_temp_directory() {
   std::filesystem::create_directory(uni_course_cpp::config::kTempDirectoryPath);
 }
 
+double get_milliseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::string print_generation_stats(
+    const uni_course_cpp::GraphGenerator::Stats& stats) {
+  std::stringstream string_to_print;
+  string_to_print << std::fixed << std::setprecision(kMillisecondsPrecision)
+                  << "{duration_ms: " << get_milliseconds(stats.duration)
+                  << ", phases_ms: {";
+  for (std::size_t i = 0; i < kPhaseNames.size(); i++) {
+    if (i != 0) {
+      string_to_print << ", ";
+    }
+    string_to_print << kPhaseNames[i] << ": "
+                    << get_milliseconds(stats.phase_durations[i]);
+  }
+  string_to_print << std::setprecision(0)
+                  << "}, vertices_per_second: "
+                  << stats.get_vertices_per_second()
+                  << ", edges_per_second: " << stats.get_edges_per_second()
+                  << "}";
+  return string_to_print.str();
+}
+
+std::string print_generation_controller_stats(
+    const uni_course_cpp::GraphGenerationController::Stats& stats) {
+  std::stringstream string_to_print;
+  string_to_print << "{graphs: " << print_generation_stats(stats.graphs)
+                  << std::fixed << std::setprecision(kMillisecondsPrecision)
+                  << ", callback_waits: {count: " << stats.callback_waits_count
+                  << ", ms: " << get_milliseconds(stats.callback_wait_duration)
+                  << "}, task_queue_waits: {count: "
+                  << stats.thread_pool.queue_waits_count << ", ms: "
+                  << get_milliseconds(stats.thread_pool.queue_wait_duration)
+                  << "}, lane_jobs: [";
+  for (std::size_t i = 0; i < stats.lane_jobs_counts.size(); i++) {
+    if (i != 0) {
+      string_to_print << ", ";
+    }
+    string_to_print << stats.lane_jobs_counts[i];
+  }
+  string_to_print << "], arenas: " << stats.arenas_count << "}";
+  return string_to_print.str();
+}
+
 std::string generation_started_string(int number_of_graph) {
   return "Graph " + std::to_string(number_of_graph) + ", Generation Started";
 }
 
 std::string generation_finished_string(int number_of_graph,
-                                       const std::string& graph_description) {
+                                       const std::string& graph_description,
+                                       const std::string& stats_description) {
   return "Graph " + std::to_string(number_of_graph) + ", Generation Finished " +
-         graph_description;
+         graph_description + ", Stats: " + stats_description;
+}
+
+std::string traversal_started_string(int number_of_graph) {
+  return "Graph " + std::to_string(number_of_graph) + ", Traversal Started";
+}
+
+std::string traversal_finished_string(
+    int number_of_graph,
+    const std::optional<uni_course_cpp::GraphPath>& princess_path) {
+  auto string = "Graph " + std::to_string(number_of_graph) +
+                ", Traversal Finished, Princess Path: ";
+  if (!princess_path.has_value()) {
+    return string + "none";
+  }
+  return string + "{duration: " + std::to_string(princess_path->duration) +
+         ", length: " + std::to_string(princess_path->length()) + "}";
+}
+
+// A graph on its way through the stages of generate_graphs().
+struct GraphJob {
+  int index = 0;
+  uni_course_cpp::Graph graph;
+  uni_course_cpp::GraphGenerator::Stats stats;
+};
+
+void push_to_stage(uni_course_cpp::BoundedQueue<GraphJob>& queue,
+                   GraphJob&& job) {
+  const auto index = job.index;
+  if (!queue.push(std::move(job))) {
+    throw std::runtime_error("Graph " + std::to_string(index) +
+                             " dropped, a later stage failed");
+  }
 }
 
-std::vector<uni_course_cpp::Graph> generate_graphs(
+// Generated graphs go through summarize -> traverse -> write stages. Every
+// stage has its own threads and a bounded queue in front of it, so a slow
+// stage, usually the write, holds back generation instead of buffering an
+// unbounded number of graphs. Graphs are streamed to their JSON files in
+// parallel chunks and aren't kept once written, and at most
+// kGraphsInFlightPerThread per thread are alive at a time, so memory doesn't
+// grow with the graphs count. `graph_seconds` receives the time from the start
+// of every graph's generation until its JSON file is written.
+uni_course_cpp::GraphGenerationController::Stats generate_graphs(
     uni_course_cpp::GraphGenerator::Params&& params,
     int graphs_count,
-    int threads_count) {
+    int threads_count,
+    std::vector<double>& graph_seconds) {
+  const auto seed = params.seed();
+  auto graph_start_times =
+      std::vector<std::chrono::steady_clock::time_point>(graphs_count);
+  graph_seconds.assign(graphs_count, 0);
   auto generation_controller = uni_course_cpp::GraphGenerationController(
-      threads_count, graphs_count, std::move(params));
+      threads_count, graphs_count, std::move(params),
+      kGraphsInFlightPerThread * std::max(threads_count, 1));
 
   auto& logger = uni_course_cpp::Logger::get_logger();
 
-  auto graphs = std::vector<uni_course_cpp::Graph>();
-  graphs.reserve(graphs_count);
+  using GraphQueue = uni_course_cpp::BoundedQueue<GraphJob>;
+  using GraphStage = uni_course_cpp::PipelineStage<GraphJob>;
+  auto summarize_queue = GraphQueue(kStageQueueCapacity);
+  auto traverse_queue = GraphQueue(kStageQueueCapacity);
+  auto write_queue = GraphQueue(kStageQueueCapacity);
 
-  generation_controller.generate(
-      [&logger](int index) { logger.log(generation_started_string(index)); },
-      [&logger, &graphs](int index, uni_course_cpp::Graph&& graph) {
-        const auto graph_description =
-            uni_course_cpp::printing::print_graph(graph);
-        logger.log(generation_finished_string(index, graph_description));
-        const auto graph_json =
-            uni_course_cpp::printing::json::print_graph(graph);
-        write_to_file(graph_json, uni_course_cpp::config::kTempDirectoryPath +
-                                      "graph_" + std::to_string(index) +
-                                      ".json");
-        graphs.push_back(std::move(graph));
-      });
+  auto traversal_controller = uni_course_cpp::GraphTraversalController(
+      threads_count,
+      [&logger](int index, const uni_course_cpp::Graph&) {
+        logger.log(traversal_started_string(index));
+      },
+      [&logger, &write_queue](
+          int index, uni_course_cpp::Graph&& graph,
+          std::optional<uni_course_cpp::GraphPath>&& princess_path) {
+        logger.log(traversal_finished_string(index, princess_path));
+        push_to_stage(write_queue, GraphJob{index, std::move(graph), {}});
+      },
+      seed);
 
-  return graphs;
+  auto summarize_stage = GraphStage(
+      kSummarizeThreadsCount, summarize_queue,
+      [&logger, &traverse_queue](GraphJob&& job) {
+        const auto trace_scope =
+            uni_course_cpp::TraceScope("summarize graph", job.index);
+        logger.log(generation_finished_string(
+            job.index, uni_course_cpp::printing::print_graph(job.graph),
+            print_generation_stats(job.stats)));
+        push_to_stage(traverse_queue, std::move(job));
+      },
+      [&traverse_queue]() { traverse_queue.close(); });
+  auto traverse_stage = GraphStage(
+      threads_count, traverse_queue,
+      [&traversal_controller](GraphJob&& job) {
+        // On the stage's own threads, generation jobs waiting for these very
+        // graphs to be written may hold every pool thread.
+        traversal_controller.traverse_on_current_thread(job.index,
+                                                        std::move(job.graph));
+      },
+      [&write_queue]() { write_queue.close(); });
+  auto write_stage = GraphStage(
+      threads_count, write_queue,
+      [&graph_start_times, &graph_seconds](GraphJob&& job) {
+        uni_course_cpp::printing::json::write_graph_to_file_parallel(
+            job.graph, uni_course_cpp::config::kTempDirectoryPath + "graph_" +
+                           std::to_string(job.index) + ".json");
+        graph_seconds[job.index] = std::chrono::duration<double>(
+                                       std::chrono::steady_clock::now() -
+                                       graph_start_times[job.index])
+                                       .count();
+      },
+      []() {});
+
+  auto generation_exception = std::exception_ptr();
+  try {
+    generation_controller.generate(
+        [&logger, &graph_start_times](int index) {
+          graph_start_times[index] = std::chrono::steady_clock::now();
+          logger.log(generation_started_string(index));
+        },
+        [&summarize_queue](int index, uni_course_cpp::Graph&& graph,
+                           const uni_course_cpp::GraphGenerator::Stats& stats) {
+          push_to_stage(summarize_queue,
+                        GraphJob{index, std::move(graph), stats});
+        });
+  } catch (...) {
+    generation_exception = std::current_exception();
+  }
+  summarize_queue.close();
+  const auto stats = generation_controller.get_stats();
+  logger.log("Generation Stats: " + print_generation_controller_stats(stats));
+
+  // A failing stage makes the ones before it fail too, so the last stages
+  // hold the original error.
+  write_stage.wait();
+  traverse_stage.wait();
+  summarize_stage.wait();
+  if (generation_exception) {
+    std::rethrow_exception(generation_exception);
+  }
+  return stats;
 }
 
-int main() {
+struct Options {
+  std::vector<int> depths;
+  std::vector<int> new_vertices_counts;
+  std::vector<int> threads_counts;
+  int graphs_count = kDefaultSweepGraphsCount;
+  std::optional<std::uint64_t> seed;
+  bool is_verbose = false;
+  bool is_tracing = false;
+
+  bool is_sweep() const {
+    return !depths.empty() || !new_vertices_counts.empty() ||
+           !threads_counts.empty();
+  }
+};
+
+std::uint64_t parse_number(const std::string& string) {
+  std::size_t parsed_length = 0;
+  const auto number = std::stoull(string, &parsed_length);
+  if (parsed_length != string.size()) {
+    throw std::invalid_argument("Not a number: " + string);
+  }
+  return number;
+}
+
+int parse_count(const std::string& string) {
+  const auto number = parse_number(string);
+  if (number > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+    throw std::invalid_argument("Number is too large: " + string);
+  }
+  return number;
+}
+
+// A flag without a value is set, a config file spells it out as true/false.
+bool parse_flag(const std::string& string) {
+  if (string.empty() || string == "true") {
+    return true;
+  }
+  if (string == "false") {
+    return false;
+  }
+  throw std::invalid_argument("Not a flag value: " + string);
+}
+
+std::vector<int> parse_counts(const std::string& string) {
+  auto counts = std::vector<int>();
+  auto stream = std::stringstream(string);
+  for (std::string item; std::getline(stream, item, ',');) {
+    const auto separator = item.find(kRangeSeparator);
+    if (separator == std::string::npos) {
+      counts.push_back(parse_count(item));
+      continue;
+    }
+    const auto first = parse_count(item.substr(0, separator));
+    const auto last =
+        parse_count(item.substr(separator + kRangeSeparator.size()));
+    for (auto count = first; count <= last; count++) {
+      counts.push_back(count);
+    }
+  }
+  if (counts.empty()) {
+    throw std::invalid_argument("Empty list: " + string);
+  }
+  return counts;
+}
+
+void read_config_file(const std::string& filename,
+                      std::map<std::string, std::string>& values) {
+  auto file = std::ifstream(filename);
+  if (!file) {
+    throw std::invalid_argument("Failed to open config " + filename);
+  }
+  for (std::string line; std::getline(file, line);) {
+    line.erase(std::remove_if(line.begin(), line.end(),
+                              [](char character) {
+                                return std::isspace(
+                                    static_cast<unsigned char>(character));
+                              }),
+               line.end());
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    const auto separator = line.find('=');
+    if (separator == std::string::npos) {
+      throw std::invalid_argument("Invalid config line: " + line);
+    }
+    // Values given on the command line are kept.
+    values.emplace(line.substr(0, separator), line.substr(separator + 1));
+  }
+}
+
+Options parse_options(int argc, char** argv) {
+  auto values = std::map<std::string, std::string>();
+  auto config_filename = std::optional<std::string>();
+  for (int i = 1; i < argc; i++) {
+    const auto argument = std::string(argv[i]);
+    if (argument.rfind("--", 0) != 0) {
+      throw std::invalid_argument("Unknown argument " + argument);
+    }
+    const auto separator = argument.find('=');
+    const auto key = argument.substr(2, separator - 2);
+    const auto value = separator == std::string::npos
+                           ? std::string()
+                           : argument.substr(separator + 1);
+    if (key == "config") {
+      config_filename = value;
+    } else {
+      values[key] = value;
+    }
+  }
+  if (config_filename.has_value()) {
+    read_config_file(config_filename.value(), values);
+  }
+
+  auto options = Options();
+  for (const auto& [key, value] : values) {
+    if (key == "depths") {
+      options.depths = parse_counts(value);
+    } else if (key == "new-vertices-counts") {
+      options.new_vertices_counts = parse_counts(value);
+    } else if (key == "threads") {
+      options.threads_counts = parse_counts(value);
+    } else if (key == "graphs-count") {
+      options.graphs_count = parse_count(value);
+    } else if (key == "seed") {
+      options.seed = parse_number(value);
+    } else if (key == "verbose") {
+      options.is_verbose = parse_flag(value);
+    } else if (key == "trace") {
+      options.is_tracing = parse_flag(value);
+    } else {
+      throw std::invalid_argument("Unknown option " + key);
+    }
+  }
+  if (options.is_sweep() &&
+      (options.depths.empty() || options.new_vertices_counts.empty() ||
+       options.threads_counts.empty())) {
+    throw std::invalid_argument(
+        "A sweep needs depths, new-vertices-counts and threads");
+  }
+  return options;
+}
+
+double get_percentile(const std::vector<double>& sorted_values,
+                      double percentile) {
+  if (sorted_values.empty()) {
+    return 0;
+  }
+  const auto rank = static_cast<std::size_t>(
+      std::ceil(percentile / 100 * sorted_values.size()));
+  return sorted_values[std::clamp<std::size_t>(rank, 1,
+                                               sorted_values.size()) -
+                       1];
+}
+
+template <typename... Values>
+void print_sweep_row(const Values&... values) {
+  ((std::cout << ' ' << std::setw(kSweepColumnWidth) << values), ...);
+  std::cout << std::endl;
+}
+
+// Runs the whole pipeline for every combination of the options and prints a
+// whitespace-separated table, one row per combination. Per-graph times are
+// measured from the start of generation until the JSON file is written.
+void run_sweep(const Options& options) {
+  const auto seed = options.seed.value_or(
+      uni_course_cpp::RandomEngine::get_random_device_seed());
+  std::cout << "# seed " << seed << ", " << options.graphs_count
+            << " graphs per row, pool of "
+            << uni_course_cpp::ThreadPool::get_thread_pool().threads_count()
+            << " threads" << std::endl;
+  print_sweep_row("threads", "depth", "new_vertices", "graphs", "vertices",
+                  "seconds", "graphs/s", "vertices/s", "p50_ms", "p99_ms");
+  std::cout << std::fixed << std::setprecision(3);
+  for (const auto depth : options.depths) {
+    for (const auto new_vertices_count : options.new_vertices_counts) {
+      for (const auto threads_count : options.threads_counts) {
+        auto graph_seconds = std::vector<double>();
+        const auto start = std::chrono::steady_clock::now();
+        const auto stats = generate_graphs(
+            uni_course_cpp::GraphGenerator::Params(depth, new_vertices_count,
+                                                   seed),
+            options.graphs_count, threads_count, graph_seconds);
+        const auto seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+        const auto vertices_count = stats.graphs.vertices_count;
+        std::sort(graph_seconds.begin(), graph_seconds.end());
+        print_sweep_row(threads_count, depth, new_vertices_count,
+                        options.graphs_count, vertices_count, seconds,
+                        options.graphs_count / seconds,
+                        vertices_count / seconds,
+                        get_percentile(graph_seconds, 50) * 1000,
+                        get_percentile(graph_seconds, 99) * 1000);
+      }
+    }
+  }
+}
+
+void run_interactive() {
   const int depth = handle_depth_input();
   const int new_vertices_count = handle_new_vertices_count_input();
   const int graphs_count = handle_graphs_count_input();
   const int threads_count = handle_threads_count_input();
-  prepare_temp_directory();
+  auto& logger = uni_course_cpp::Logger::get_logger();
+  logger.set_mode(uni_course_cpp::Logger::Mode::Async);
 
   auto params =
       uni_course_cpp::GraphGenerator::Params(depth, new_vertices_count);
-  const auto graphs =
-      generate_graphs(std::move(params), graphs_count, threads_count);
+  auto graph_seconds = std::vector<double>();
+  generate_graphs(std::move(params), graphs_count, threads_count,
+                  graph_seconds);
+}
+
+int main(int argc, char** argv) {
+  auto options = Options();
+  try {
+    options = parse_options(argc, argv);
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n" << kUsage;
+    return 1;
+  }
+  // The Logger opens its file on first use, so the directory comes first.
+  prepare_temp_directory();
+  auto& tracer = uni_course_cpp::Tracer::get_tracer();
+  if (options.is_tracing) {
+    tracer.set_enabled(true);
+    tracer.set_thread_name("main");
+  }
+
+  auto& logger = uni_course_cpp::Logger::get_logger();
+  auto error_message = std::optional<std::string>();
+  try {
+    if (options.is_sweep()) {
+      logger.set_console_enabled(options.is_verbose);
+      logger.set_mode(uni_course_cpp::Logger::Mode::Async);
+      run_sweep(options);
+    } else {
+      run_interactive();
+    }
+  } catch (const std::exception& error) {
+    error_message = error.what();
+  }
+  // Lines queued before a failure are written too.
+  logger.set_mode(uni_course_cpp::Logger::Mode::Blocking);
+
+  if (options.is_tracing) {
+    tracer.set_enabled(false);
+    tracer.write_to_file(uni_course_cpp::config::kTraceFilePath);
+  }
+  if (error_message.has_value()) {
+    std::cerr << error_message.value() << std::endl;
+    return 1;
+  }
   return 0;
 }
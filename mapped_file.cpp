@@ -0,0 +1,46 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace uni_course_cpp {
+
+MappedFile::MappedFile(const std::string& filename) {
+  const int file_descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (file_descriptor < 0) {
+    throw std::runtime_error("Failed to open " + filename + ": " +
+                             std::strerror(errno));
+  }
+  struct stat file_stat {};
+  if (::fstat(file_descriptor, &file_stat) != 0) {
+    const auto error = errno;
+    ::close(file_descriptor);
+    throw std::runtime_error("Failed to stat " + filename + ": " +
+                             std::strerror(error));
+  }
+  size_ = file_stat.st_size;
+  if (size_ == 0) {
+    ::close(file_descriptor);
+    return;
+  }
+  data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  const auto error = errno;
+  ::close(file_descriptor);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error("Failed to map " + filename + ": " +
+                             std::strerror(error));
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+}
+
+}  // namespace uni_course_cpp
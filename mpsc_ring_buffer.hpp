@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace uni_course_cpp {
+
+// Bounded lock-free queue for many producers and one consumer. Every slot
+// carries a sequence number that tells whose turn it is, so producers only
+// race on the enqueue position and never block each other while copying.
+template <typename Value>
+class MpscRingBuffer {
+ public:
+  explicit MpscRingBuffer(std::size_t capacity)
+      : slots_(std::make_unique<Slot[]>(capacity)), mask_(capacity - 1) {
+    assert(capacity > 0 && (capacity & mask_) == 0 &&
+           "Capacity must be a power of two");
+    for (std::size_t i = 0; i < capacity; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingBuffer(const MpscRingBuffer&) = delete;
+  MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+  // Returns false and leaves `value` untouched if the buffer is full.
+  bool try_push(Value& value) {
+    auto position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots_[position & mask_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Must only be called from the consumer thread.
+  std::optional<Value> try_pop() {
+    auto& slot = slots_[dequeue_position_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) !=
+        dequeue_position_ + 1) {
+      return std::nullopt;
+    }
+    auto value = std::optional<Value>(std::move(slot.value));
+    slot.sequence.store(dequeue_position_ + mask_ + 1,
+                        std::memory_order_release);
+    dequeue_position_++;
+    return value;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence = 0;
+    Value value;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t mask_;
+  alignas(64) std::atomic<std::size_t> enqueue_position_ = 0;
+  alignas(64) std::size_t dequeue_position_ = 0;
+};
+
+}  // namespace uni_course_cpp
@@ -0,0 +1,130 @@
+#include "output_buffer.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "tracer.hpp"
+
+namespace {
+
+struct FreeStorage {
+  std::unique_ptr<char[]> storage;
+  std::size_t capacity = 0;
+};
+
+// Buffers of the file descriptor sinks that finished on this thread. A
+// thread rarely has more than two sinks open at once, so the list stays
+// short.
+thread_local std::vector<FreeStorage> free_storages;
+
+std::unique_ptr<char[]> acquire_storage(std::size_t capacity) {
+  for (auto it = free_storages.rbegin(); it != free_storages.rend(); ++it) {
+    if (it->capacity == capacity) {
+      auto storage = std::move(it->storage);
+      free_storages.erase(std::next(it).base());
+      return storage;
+    }
+  }
+  // Left uninitialized, only the written part is ever read.
+  return std::unique_ptr<char[]>(new char[capacity]);
+}
+
+void release_storage(std::unique_ptr<char[]>&& storage, std::size_t capacity) {
+  free_storages.push_back({std::move(storage), capacity});
+}
+
+void write_to_file_descriptor(int file_descriptor,
+                              const char* data,
+                              std::size_t size) {
+  const auto trace_scope = uni_course_cpp::TraceScope("file write");
+  while (size != 0) {
+    const auto written = ::write(file_descriptor, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to write output: " +
+                               std::string(std::strerror(errno)));
+    }
+    data += written;
+    size -= written;
+  }
+}
+}  // namespace
+
+namespace uni_course_cpp {
+namespace printing {
+
+OutputBuffer::OutputBuffer(int file_descriptor, std::size_t capacity)
+    : capacity_(std::max(capacity, kMaxNumberLength)),
+      initial_capacity_(capacity_),
+      file_descriptor_(file_descriptor),
+      storage_(acquire_storage(capacity_)) {
+  data_ = storage_.get();
+}
+
+OutputBuffer::OutputBuffer(std::string& string, std::size_t capacity)
+    : initial_capacity_(std::max(capacity, kMaxNumberLength)),
+      string_(&string),
+      string_size_(string.size()) {}
+
+void OutputBuffer::write(std::string_view string) {
+  reserve(string.size());
+  if (string.size() > capacity_) {
+    write_to_file_descriptor(file_descriptor_, string.data(), string.size());
+    return;
+  }
+  std::memcpy(data_ + size_, string.data(), string.size());
+  size_ += string.size();
+}
+
+void OutputBuffer::write(char character) {
+  reserve(1);
+  data_[size_++] = character;
+}
+
+void OutputBuffer::write(int number) {
+  reserve(kMaxNumberLength);
+  const auto result = std::to_chars(data_ + size_, data_ + capacity_, number);
+  size_ = result.ptr - data_;
+}
+
+void OutputBuffer::make_room(std::size_t size) {
+  if (string_ == nullptr) {
+    // Strings longer than the buffer are written straight through.
+    flush();
+    return;
+  }
+  capacity_ = std::max({size_ + size, 2 * capacity_, initial_capacity_});
+  string_->resize(string_size_ + capacity_);
+  data_ = string_->data() + string_size_;
+}
+
+void OutputBuffer::flush() {
+  if (string_ != nullptr) {
+    string_size_ += size_;
+    string_->resize(string_size_);
+    data_ = nullptr;
+    capacity_ = 0;
+  } else if (size_ != 0) {
+    write_to_file_descriptor(file_descriptor_, data_, size_);
+  }
+  size_ = 0;
+}
+
+OutputBuffer::~OutputBuffer() {
+  try {
+    flush();
+  } catch (...) {
+  }
+  if (storage_ != nullptr) {
+    release_storage(std::move(storage_), initial_capacity_);
+  }
+}
+
+}  // namespace printing
+}  // namespace uni_course_cpp
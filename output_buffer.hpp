@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace uni_course_cpp {
+namespace printing {
+
+// Collects small writes into one buffer, so that serializing doesn't allocate
+// or make a syscall per token. A file descriptor gets the buffer once it is
+// full; the buffer comes from a per-thread free list, so a thread reuses the
+// same storage for every file it writes. A string is its own buffer: writes
+// go straight into its spare room, grown geometrically, and flush() trims it.
+class OutputBuffer {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 1 << 20;
+  static constexpr std::size_t kDefaultStringCapacity = 1 << 12;
+
+  explicit OutputBuffer(int file_descriptor,
+                        std::size_t capacity = kDefaultCapacity);
+  explicit OutputBuffer(std::string& string,
+                        std::size_t capacity = kDefaultStringCapacity);
+
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  void write(std::string_view string);
+  void write(char character);
+  void write(int number);
+
+  void flush();
+
+  ~OutputBuffer();
+
+ private:
+  static constexpr int kNoFileDescriptor = -1;
+  static constexpr std::size_t kMaxNumberLength = 16;
+
+  void reserve(std::size_t size) {
+    if (size_ + size > capacity_) {
+      make_room(size);
+    }
+  }
+
+  void make_room(std::size_t size);
+
+  char* data_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+  std::size_t initial_capacity_ = 0;
+  int file_descriptor_ = kNoFileDescriptor;
+  std::unique_ptr<char[]> storage_;
+  std::string* string_ = nullptr;
+  // Length of the string up to the first byte of `data_`.
+  std::size_t string_size_ = 0;
+};
+
+}  // namespace printing
+}  // namespace uni_course_cpp
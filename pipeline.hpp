@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace uni_course_cpp {
+
+// Blocking queue between two pipeline stages. A full queue blocks producers,
+// so a slow stage holds back the ones before it instead of piling up values.
+template <typename Value>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {
+    assert(capacity > 0 && "Capacity must be positive");
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Blocks while the queue is full. Returns false and drops `value` if the
+  // queue was cancelled.
+  bool push(Value&& value) {
+    std::unique_lock lock(mutex_);
+    assert(!is_closed_ && "Queue is closed");
+    not_full_.wait(lock, [this]() {
+      return values_.size() < capacity_ || is_cancelled_;
+    });
+    if (is_cancelled_) {
+      return false;
+    }
+    values_.push_back(std::move(value));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Blocks while the queue is empty and open. Returns nothing once the queue
+  // is closed and drained, or cancelled.
+  std::optional<Value> pop() {
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [this]() {
+      return !values_.empty() || is_closed_ || is_cancelled_;
+    });
+    if (values_.empty() || is_cancelled_) {
+      return std::nullopt;
+    }
+    auto value = std::move(values_.front());
+    values_.pop_front();
+    not_full_.notify_one();
+    return value;
+  }
+
+  // Nothing is pushed anymore, consumers stop once the queue is drained.
+  void close() {
+    const std::lock_guard lock(mutex_);
+    is_closed_ = true;
+    not_empty_.notify_all();
+  }
+
+  // Drops every queued value and fails all pushes from now on, for when the
+  // consumers stopped on an error.
+  void cancel() {
+    const std::lock_guard lock(mutex_);
+    is_cancelled_ = true;
+    values_.clear();
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  const std::size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<Value> values_;
+  bool is_closed_ = false;
+  bool is_cancelled_ = false;
+};
+
+// Threads of one pipeline stage, each pops values from `input` and processes
+// them until the queue is closed and drained. The stages own their threads
+// rather than borrowing the ThreadPool: they block on queues, which would
+// starve the pool of threads for the stages that have to make room.
+template <typename Value>
+class PipelineStage {
+ public:
+  using Process = std::function<void(Value&& value)>;
+  using Finish = std::function<void()>;
+
+  // `finish` runs once after the last thread is done, usually to close the
+  // queue of the next stage. If `process` throws, `input` is cancelled so
+  // that the stages before this one stop too.
+  PipelineStage(int threads_count,
+                BoundedQueue<Value>& input,
+                const Process& process,
+                const Finish& finish)
+      : input_(input),
+        process_(process),
+        finish_(finish),
+        running_threads_count_(std::max(threads_count, 1)) {
+    for (int i = 0; i < running_threads_count_; i++) {
+      threads_.emplace_back([this]() { run(); });
+    }
+  }
+
+  PipelineStage(const PipelineStage&) = delete;
+  PipelineStage& operator=(const PipelineStage&) = delete;
+
+  // Waits until the stage is done and rethrows the first exception thrown by
+  // `process` or `finish`.
+  void wait() {
+    join();
+    if (exception_) {
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+  ~PipelineStage() { join(); }
+
+ private:
+  void run() {
+    try {
+      while (auto value = input_.pop()) {
+        process_(std::move(value.value()));
+      }
+    } catch (...) {
+      set_exception(std::current_exception());
+      input_.cancel();
+    }
+    if (--running_threads_count_ == 0) {
+      try {
+        finish_();
+      } catch (...) {
+        set_exception(std::current_exception());
+      }
+    }
+  }
+
+  void set_exception(std::exception_ptr exception) {
+    const std::lock_guard lock(exception_mutex_);
+    if (!exception_) {
+      exception_ = exception;
+    }
+  }
+
+  void join() {
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  BoundedQueue<Value>& input_;
+  Process process_;
+  Finish finish_;
+  std::atomic<int> running_threads_count_;
+  std::mutex exception_mutex_;
+  std::exception_ptr exception_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace uni_course_cpp
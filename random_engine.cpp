@@ -0,0 +1,113 @@
+#include "random_engine.hpp"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+static constexpr std::uint64_t kGoldenGamma = 0x9e3779b97f4a7c15;
+static constexpr std::uint64_t kCounterGamma = 0xd1b54a32d192ed03;
+
+std::uint64_t mix(std::uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+
+std::uint64_t split_mix(std::uint64_t& state) {
+  state += kGoldenGamma;
+  return mix(state);
+}
+
+std::uint64_t get_boolean_threshold(double probability) {
+  if (probability <= 0) {
+    return 0;
+  }
+  if (probability >= 1) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  return static_cast<std::uint64_t>(probability * 0x1p64);
+}
+
+int scale_to_limit(std::uint64_t random_value, int limit) {
+  const auto range = static_cast<std::uint64_t>(limit) + 1;
+  return static_cast<int>(((random_value >> 32) * range) >> 32);
+}
+}  // namespace
+
+namespace uni_course_cpp {
+
+RandomEngine::RandomEngine(std::uint64_t seed) {
+  for (auto& word : state_) {
+    word = split_mix(seed);
+  }
+}
+
+std::uint64_t RandomEngine::get_random_device_seed() {
+  std::random_device rd;
+  return (static_cast<std::uint64_t>(rd()) << 32) | rd();
+}
+
+RandomEngine& RandomEngine::get_thread_engine() {
+  thread_local RandomEngine engine(get_random_device_seed());
+  return engine;
+}
+
+bool RandomEngine::random_boolean(double probability) {
+  if (probability >= 1) {
+    return true;
+  }
+  return (*this)() < get_boolean_threshold(probability);
+}
+
+RandomStream::RandomStream(std::uint64_t seed, std::uint64_t stream)
+    : stream_key_(mix(mix(seed + kGoldenGamma) ^ (stream * kCounterGamma))) {}
+
+std::uint64_t RandomStream::get(std::uint64_t key,
+                                std::uint64_t counter) const {
+  return mix(mix(stream_key_ ^ (key * kGoldenGamma)) +
+             (counter + 1) * kCounterGamma);
+}
+
+bool RandomStream::random_boolean(double probability,
+                                  std::uint64_t key,
+                                  std::uint64_t counter) const {
+  if (probability >= 1) {
+    return true;
+  }
+  return get(key, counter) < get_boolean_threshold(probability);
+}
+
+int RandomStream::random_int(int limit,
+                             std::uint64_t key,
+                             std::uint64_t counter) const {
+  return scale_to_limit(get(key, counter), limit);
+}
+
+void RandomStream::random_booleans(double probability,
+                                   const int* keys,
+                                   std::size_t count,
+                                   std::uint64_t counter,
+                                   std::vector<std::uint8_t>& booleans) const {
+  booleans.resize(count);
+  if (probability >= 1) {
+    std::fill(booleans.begin(), booleans.end(), true);
+    return;
+  }
+  const auto threshold = get_boolean_threshold(probability);
+  for (std::size_t i = 0; i < count; i++) {
+    booleans[i] = get(keys[i], counter) < threshold;
+  }
+}
+
+void RandomStream::random_ints(int limit,
+                               const int* keys,
+                               std::size_t count,
+                               std::uint64_t counter,
+                               std::vector<int>& ints) const {
+  ints.resize(count);
+  for (std::size_t i = 0; i < count; i++) {
+    ints[i] = scale_to_limit(get(keys[i], counter), limit);
+  }
+}
+
+}  // namespace uni_course_cpp
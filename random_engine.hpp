@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace uni_course_cpp {
+
+// xoshiro256** generator. Cheap to seed and copy, so every thread can own one.
+class RandomEngine {
+ public:
+  using result_type = std::uint64_t;
+
+  explicit RandomEngine(std::uint64_t seed);
+
+  static RandomEngine& get_thread_engine();
+
+  static std::uint64_t get_random_device_seed();
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    const auto result = rotate_left(state_[1] * 5, 7) * 9;
+    const auto shifted = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= shifted;
+    state_[3] = rotate_left(state_[3], 45);
+    return result;
+  }
+
+  bool random_boolean(double probability);
+
+ private:
+  static result_type rotate_left(result_type value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+  }
+
+  result_type state_[4] = {};
+};
+
+// Counter-based generator: every value is a pure function of
+// (seed, stream, key, counter), so the result doesn't depend on which thread
+// draws it or in which order.
+class RandomStream {
+ public:
+  RandomStream(std::uint64_t seed, std::uint64_t stream);
+
+  std::uint64_t get(std::uint64_t key, std::uint64_t counter = 0) const;
+
+  bool random_boolean(double probability,
+                      std::uint64_t key,
+                      std::uint64_t counter = 0) const;
+
+  // Returns a uniformly distributed value in [0, limit].
+  int random_int(int limit, std::uint64_t key, std::uint64_t counter = 0) const;
+
+  void random_booleans(double probability,
+                       const int* keys,
+                       std::size_t count,
+                       std::uint64_t counter,
+                       std::vector<std::uint8_t>& booleans) const;
+
+  void random_ints(int limit,
+                   const int* keys,
+                   std::size_t count,
+                   std::uint64_t counter,
+                   std::vector<int>& ints) const;
+
+ private:
+  std::uint64_t stream_key_ = 0;
+};
+
+}  // namespace uni_course_cpp
@@ -0,0 +1,238 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include "tracer.hpp"
+
+namespace {
+
+static constexpr int kNotPoolThreadIndex = -1;
+
+thread_local const void* current_thread_pool = nullptr;
+thread_local int current_worker_index = kNotPoolThreadIndex;
+}  // namespace
+
+namespace uni_course_cpp {
+
+ThreadPool& ThreadPool::get_thread_pool() {
+  static ThreadPool thread_pool(
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+  return thread_pool;
+}
+
+ThreadPool::ThreadPool(int threads_count) {
+  for (int i = 0; i < threads_count; i++) {
+    worker_queues_.push_back(std::make_unique<TaskQueue>());
+  }
+  threads_.reserve(threads_count);
+  for (int i = 0; i < threads_count; i++) {
+    threads_.emplace_back([this, i]() { run_worker(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  should_terminate_ = true;
+  {
+    const std::lock_guard lock(sleep_mutex_);
+    state_changed_.notify_all();
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+ThreadPool::Stats ThreadPool::get_stats() const {
+  auto stats = Stats();
+  const auto add_queue_stats = [&stats](const TaskQueue& queue) {
+    stats.queue_wait_duration += std::chrono::nanoseconds(
+        queue.wait_nanoseconds.load(std::memory_order_relaxed));
+    stats.queue_waits_count +=
+        queue.waits_count.load(std::memory_order_relaxed);
+  };
+  for (const auto& queue : worker_queues_) {
+    add_queue_stats(*queue);
+  }
+  add_queue_stats(injection_queue_);
+  return stats;
+}
+
+std::unique_lock<std::mutex> ThreadPool::lock_queue(std::mutex& mutex) {
+  auto lock = std::unique_lock(mutex, std::try_to_lock);
+  if (lock.owns_lock()) {
+    return lock;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  lock.lock();
+  const std::int64_t wait_nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  if (current_thread_pool == this) {
+    auto& queue = *worker_queues_[current_worker_index];
+    queue.wait_nanoseconds.store(
+        queue.wait_nanoseconds.load(std::memory_order_relaxed) +
+            wait_nanoseconds,
+        std::memory_order_relaxed);
+    queue.waits_count.store(
+        queue.waits_count.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  } else {
+    injection_queue_.wait_nanoseconds.fetch_add(wait_nanoseconds,
+                                                std::memory_order_relaxed);
+    injection_queue_.waits_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  return lock;
+}
+
+std::optional<ThreadPool::Task> ThreadPool::pop_front(TaskQueue& queue) {
+  const auto lock = lock_queue(queue.mutex);
+  if (queue.tasks.empty()) {
+    return std::nullopt;
+  }
+  auto task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  return task;
+}
+
+std::optional<ThreadPool::Task> ThreadPool::pop_back(TaskQueue& queue) {
+  const auto lock = lock_queue(queue.mutex);
+  if (queue.tasks.empty()) {
+    return std::nullopt;
+  }
+  auto task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return task;
+}
+
+void ThreadPool::submit(Task task) {
+  if (current_thread_pool == this) {
+    auto& queue = *worker_queues_[current_worker_index];
+    const auto lock = lock_queue(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+    nested_tasks_count_++;
+  } else {
+    const auto lock = lock_queue(injection_queue_.mutex);
+    injection_queue_.tasks.push_back(std::move(task));
+    injected_tasks_count_++;
+  }
+  notify_waiters();
+}
+
+void ThreadPool::notify_waiters() {
+  if (sleeping_threads_count_ == 0) {
+    return;
+  }
+  const std::lock_guard lock(sleep_mutex_);
+  state_changed_.notify_all();
+}
+
+std::optional<ThreadPool::Task> ThreadPool::take_nested_task() {
+  if (nested_tasks_count_ == 0) {
+    return std::nullopt;
+  }
+  const int queues_count = worker_queues_.size();
+  const bool is_pool_thread = current_thread_pool == this;
+  if (is_pool_thread) {
+    auto& queue = *worker_queues_[current_worker_index];
+    if (auto task = pop_back(queue)) {
+      nested_tasks_count_--;
+      return task;
+    }
+  }
+  const int first_victim_index = is_pool_thread ? current_worker_index + 1 : 0;
+  for (int i = 0; i < queues_count; i++) {
+    auto& queue = *worker_queues_[(first_victim_index + i) % queues_count];
+    if (auto task = pop_front(queue)) {
+      nested_tasks_count_--;
+      return task;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<ThreadPool::Task> ThreadPool::take_injected_task() {
+  if (injected_tasks_count_ == 0) {
+    return std::nullopt;
+  }
+  auto task = pop_front(injection_queue_);
+  if (task.has_value()) {
+    injected_tasks_count_--;
+  }
+  return task;
+}
+
+void ThreadPool::wait_until(const std::function<bool()>& is_done) {
+  while (!is_done()) {
+    if (const auto task = take_nested_task()) {
+      task.value()();
+      continue;
+    }
+    std::unique_lock lock(sleep_mutex_);
+    sleeping_threads_count_++;
+    state_changed_.wait(lock, [this, &is_done]() {
+      return is_done() || nested_tasks_count_ > 0;
+    });
+    sleeping_threads_count_--;
+  }
+}
+
+void ThreadPool::run_worker(int worker_index) {
+  current_thread_pool = this;
+  current_worker_index = worker_index;
+  Tracer::get_tracer().set_thread_name("pool worker " +
+                                       std::to_string(worker_index));
+  while (true) {
+    auto task = take_nested_task();
+    if (!task.has_value()) {
+      task = take_injected_task();
+    }
+    if (task.has_value()) {
+      task.value()();
+      continue;
+    }
+    std::unique_lock lock(sleep_mutex_);
+    sleeping_threads_count_++;
+    state_changed_.wait(lock, [this]() {
+      return should_terminate_ || nested_tasks_count_ > 0 ||
+             injected_tasks_count_ > 0;
+    });
+    sleeping_threads_count_--;
+    if (should_terminate_ && nested_tasks_count_ == 0 &&
+        injected_tasks_count_ == 0) {
+      return;
+    }
+  }
+}
+
+void TaskGroup::run(ThreadPool::Task task) {
+  pending_tasks_count_++;
+  thread_pool_.submit([this, &thread_pool = thread_pool_,
+                       task = std::move(task)]() {
+    try {
+      task();
+    } catch (...) {
+      const std::lock_guard lock(exception_mutex_);
+      if (!exception_) {
+        exception_ = std::current_exception();
+      }
+    }
+    if (--pending_tasks_count_ == 0) {
+      thread_pool.notify_waiters();
+    }
+  });
+}
+
+void TaskGroup::wait() {
+  thread_pool_.wait_until([this]() { return pending_tasks_count_ == 0; });
+  const std::lock_guard lock(exception_mutex_);
+  if (exception_) {
+    std::rethrow_exception(std::exchange(exception_, nullptr));
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  thread_pool_.wait_until([this]() { return pending_tasks_count_ == 0; });
+}
+
+}  // namespace uni_course_cpp
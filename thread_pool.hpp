@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace uni_course_cpp {
+
+// Process-wide work-stealing pool. Every pool thread owns a deque: it pushes
+// and pops nested tasks at the back and idle threads steal from the front.
+// Tasks submitted from outside the pool go to a shared injection queue.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  // Time threads spent blocked on a task queue mutex someone else held. Only
+  // contended locks are timed, so the uncontended path stays a try_lock.
+  struct Stats {
+    std::chrono::nanoseconds queue_wait_duration =
+        std::chrono::nanoseconds::zero();
+    std::uint64_t queue_waits_count = 0;
+  };
+
+  static ThreadPool& get_thread_pool();
+
+  void submit(Task task);
+
+  // Runs nested tasks on the calling thread until `is_done` returns true.
+  // Injected tasks are left to idle pool threads, so waiting never starts an
+  // unrelated top-level job on top of the current one.
+  void wait_until(const std::function<bool()>& is_done);
+
+  // Wakes sleeping threads after the atomic state they wait on changed. Only
+  // locks when a thread sleeps: a sleeper counts itself before checking that
+  // state, both sequentially consistent, so either it sees the change or the
+  // notifier sees it.
+  void notify_waiters();
+
+  int threads_count() const { return threads_.size(); }
+
+  // Totals since the pool was created, subtract two snapshots to get the
+  // numbers of a single run.
+  Stats get_stats() const;
+
+ private:
+  // Wait counters are written only by the thread owning the queue, threads
+  // outside the pool share the ones of the injection queue.
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::atomic<std::int64_t> wait_nanoseconds = 0;
+    std::atomic<std::uint64_t> waits_count = 0;
+  };
+
+  explicit ThreadPool(int threads_count);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  std::unique_lock<std::mutex> lock_queue(std::mutex& mutex);
+  std::optional<Task> pop_front(TaskQueue& queue);
+  std::optional<Task> pop_back(TaskQueue& queue);
+  std::optional<Task> take_nested_task();
+  std::optional<Task> take_injected_task();
+  void run_worker(int worker_index);
+
+  std::vector<std::unique_ptr<TaskQueue>> worker_queues_;
+  TaskQueue injection_queue_;
+  std::vector<std::thread> threads_;
+  std::atomic<int> nested_tasks_count_ = 0;
+  std::atomic<int> injected_tasks_count_ = 0;
+  std::atomic<bool> should_terminate_ = false;
+  std::mutex sleep_mutex_;
+  std::condition_variable state_changed_;
+  std::atomic<int> sleeping_threads_count_ = 0;
+};
+
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& thread_pool = ThreadPool::get_thread_pool())
+      : thread_pool_(thread_pool) {}
+
+  void run(ThreadPool::Task task);
+
+  // Helps the pool until every task of the group has finished, then rethrows
+  // the first exception thrown by any of them.
+  void wait();
+
+  ~TaskGroup();
+
+ private:
+  ThreadPool& thread_pool_;
+  std::atomic<int> pending_tasks_count_ = 0;
+  std::mutex exception_mutex_;
+  std::exception_ptr exception_;
+};
+
+}  // namespace uni_course_cpp
@@ -0,0 +1,118 @@
+#include "tracer.hpp"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+static constexpr int kProcessId = 1;
+static constexpr int kMicrosecondsPrecision = 3;
+
+thread_local uni_course_cpp::Tracer* current_tracer = nullptr;
+thread_local void* current_thread_buffer = nullptr;
+
+double get_microseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+}  // namespace
+
+namespace uni_course_cpp {
+
+Tracer& Tracer::get_tracer() {
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::ThreadBuffer& Tracer::get_thread_buffer() {
+  if (current_tracer != this) {
+    const std::lock_guard lock(buffers_mutex_);
+    auto& buffer = buffers_.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->thread_id = buffers_.size();
+    buffer->thread_name = "thread " + std::to_string(buffer->thread_id);
+    current_tracer = this;
+    current_thread_buffer = buffer.get();
+  }
+  return *static_cast<ThreadBuffer*>(current_thread_buffer);
+}
+
+void Tracer::set_thread_name(const std::string& name) {
+  auto& buffer = get_thread_buffer();
+  const std::lock_guard lock(buffers_mutex_);
+  buffer.thread_name = name;
+}
+
+void Tracer::add_event(const char* name,
+                       Clock::time_point start,
+                       Clock::time_point end,
+                       std::int64_t index) {
+  auto& buffer = get_thread_buffer();
+  const auto events_count =
+      buffer.events_count.load(std::memory_order_relaxed);
+  const auto chunk_index = events_count / ThreadBuffer::kChunkSize;
+  if (chunk_index == ThreadBuffer::kMaxChunksCount) {
+    buffer.dropped_events_count.store(
+        buffer.dropped_events_count.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    return;
+  }
+  auto& chunk = buffer.chunks[chunk_index];
+  if (chunk == nullptr) {
+    chunk = std::make_unique<Event[]>(ThreadBuffer::kChunkSize);
+  }
+  chunk[events_count % ThreadBuffer::kChunkSize] = {name, start, end, index};
+  buffer.events_count.store(events_count + 1, std::memory_order_release);
+}
+
+void Tracer::write_to_file(const std::string& filename) const {
+  auto file = std::ofstream(filename);
+  if (!file) {
+    throw std::runtime_error("Failed to open " + filename);
+  }
+  file << std::fixed << std::setprecision(kMicrosecondsPrecision)
+       << "{\"traceEvents\": [\n";
+  bool is_first = true;
+  const auto write_separator = [&file, &is_first]() {
+    if (!is_first) {
+      file << ",\n";
+    }
+    is_first = false;
+  };
+
+  const std::lock_guard lock(buffers_mutex_);
+  for (const auto& buffer : buffers_) {
+    write_separator();
+    file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": "
+         << kProcessId << ", \"tid\": " << buffer->thread_id
+         << ", \"args\": {\"name\": \"" << buffer->thread_name << "\"}}";
+    const auto events_count =
+        buffer->events_count.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < events_count; i++) {
+      const auto& event = buffer->chunks[i / ThreadBuffer::kChunkSize]
+                                        [i % ThreadBuffer::kChunkSize];
+      write_separator();
+      file << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": "
+           << kProcessId << ", \"tid\": " << buffer->thread_id
+           << ", \"ts\": " << get_microseconds(event.start - start_time_)
+           << ", \"dur\": " << get_microseconds(event.end - event.start);
+      if (event.index != kNoIndex) {
+        file << ", \"args\": {\"index\": " << event.index << "}";
+      }
+      file << "}";
+    }
+    const auto dropped_events_count =
+        buffer->dropped_events_count.load(std::memory_order_relaxed);
+    if (dropped_events_count != 0) {
+      write_separator();
+      file << "{\"name\": \"dropped events\", \"ph\": \"i\", \"s\": \"t\", "
+           << "\"pid\": " << kProcessId << ", \"tid\": " << buffer->thread_id
+           << ", \"ts\": 0, \"args\": {\"count\": " << dropped_events_count
+           << "}}";
+    }
+  }
+  file << "\n]}\n";
+  if (!file) {
+    throw std::runtime_error("Failed to write " + filename);
+  }
+}
+
+}  // namespace uni_course_cpp
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace uni_course_cpp {
+
+// Records how long pieces of work took on every thread and writes them as a
+// Chrome trace-event file, which chrome://tracing and ui.perfetto.dev open.
+// Every thread appends to its own buffer without locking. Nothing is recorded
+// until set_enabled(true).
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::int64_t kNoIndex = -1;
+
+  static Tracer& get_tracer();
+
+  void set_enabled(bool is_enabled) {
+    is_enabled_.store(is_enabled, std::memory_order_relaxed);
+  }
+
+  bool is_enabled() const {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Names the calling thread's row of the timeline.
+  void set_thread_name(const std::string& name);
+
+  // `name` isn't copied, pass a string literal. Events past the capacity of
+  // the thread's buffer are dropped and counted.
+  void add_event(const char* name,
+                 Clock::time_point start,
+                 Clock::time_point end,
+                 std::int64_t index = kNoIndex);
+
+  // Writes every event recorded so far, events added concurrently may be
+  // left out.
+  void write_to_file(const std::string& filename) const;
+
+ private:
+  struct Event {
+    const char* name = nullptr;
+    Clock::time_point start;
+    Clock::time_point end;
+    std::int64_t index = kNoIndex;
+  };
+
+  // Chunks are allocated and events appended by the owning thread only,
+  // `events_count` publishes them to the thread writing the file.
+  struct ThreadBuffer {
+    static constexpr std::size_t kChunkSize = 1 << 12;
+    static constexpr std::size_t kMaxChunksCount = 1 << 8;
+
+    int thread_id = 0;
+    std::string thread_name;
+    std::array<std::unique_ptr<Event[]>, kMaxChunksCount> chunks;
+    std::atomic<std::size_t> events_count = 0;
+    std::atomic<std::size_t> dropped_events_count = 0;
+  };
+
+  Tracer() = default;
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+  Tracer(Tracer&&) = delete;
+  Tracer& operator=(Tracer&&) = delete;
+
+  ThreadBuffer& get_thread_buffer();
+
+  std::atomic<bool> is_enabled_ = false;
+  const Clock::time_point start_time_ = Clock::now();
+  // Guards the list of buffers and the thread names, not the events.
+  mutable std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// Adds an event spanning its own lifetime if tracing was enabled when it was
+// created.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name, std::int64_t index = Tracer::kNoIndex)
+      : name_(Tracer::get_tracer().is_enabled() ? name : nullptr),
+        index_(index) {
+    if (name_ != nullptr) {
+      start_ = Tracer::Clock::now();
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  ~TraceScope() {
+    if (name_ != nullptr) {
+      Tracer::get_tracer().add_event(name_, start_, Tracer::Clock::now(),
+                                     index_);
+    }
+  }
+
+ private:
+  const char* name_ = nullptr;
+  std::int64_t index_ = Tracer::kNoIndex;
+  Tracer::Clock::time_point start_;
+};
+
+}  // namespace uni_course_cpp